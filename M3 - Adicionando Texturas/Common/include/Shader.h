@@ -7,6 +7,10 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
 
 //GLAD
 #include <glad/glad.h>
@@ -14,15 +18,47 @@
 // GLFW
 #include <GLFW/glfw3.h>
 
+#include "ProgramCache.h"
+
 using namespace std;
 
+// Uniform ativo do programa, lido uma vez depois do link, com o ultimo valor enviado
+struct ShaderUniform
+{
+	string name;
+	GLenum type;     // GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D...
+	GLint location;
+	GLfloat value[16]; // ints e bools guardados pelos bits
+	bool hasValue;
+};
+
+// Indice na tabela de uniforms do Shader (-1 = nao existe ou foi eliminado pelo compilador)
+typedef int UniformHandle;
+
+// Custo de criar os programas, em ms. compile e link sao o tempo dentro das chamadas;
+// wait e o tempo parado no finish() esperando o status (o driver pode deixar o trabalho
+// para essa hora, ou para outras threads com GL_KHR_parallel_shader_compile).
+struct ShaderTiming
+{
+	double readMs = 0;
+	double compileMs = 0;
+	double linkMs = 0;
+	double waitMs = 0;
+	double cacheMs = 0;   // ler ou gravar o binario no ProgramCache
+	int nbPrograms = 0;
+	int nbCached = 0;     // programas que vieram do cache, sem compilar
+};
+
 class Shader
 {
 public:
 	GLuint ID;
-	// Constructor generates the shader on the fly
-	Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
+	// Constructor generates the shader on the fly. Com wait = false so manda compilar e
+	// linkar: o programa so pode ser usado depois do finish() (ver ShaderManager).
+	// defines (linhas "#define ...") entram logo depois do #version dos dois shaders
+	Shader(const GLchar* vertexPath, const GLchar* fragmentPath, bool wait = true, const string& defines = "")
 	{
+		Clock::time_point start = Clock::now();
 		// 1. Retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
 		std::string fragmentCode;
@@ -51,85 +87,332 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+		timing.readMs = elapsedMs(start);
+
+		if (!defines.empty())
+		{
+			vertexCode = insertDefines(vertexCode, defines);
+			fragmentCode = insertDefines(fragmentCode, defines);
+		}
+
+		// Programa ja linkado de uma execucao anterior, se os fontes e o driver nao mudaram
+		ProgramCache cache;
+		cacheName = string(vertexPath) + "|" + fragmentPath;
+		if (!defines.empty())
+			cacheName += "|" + defines;
+		sourceHash = ProgramCache::hashSources(vertexCode, fragmentCode);
+
+		start = Clock::now();
+		this->ID = cache.load(cacheName, sourceHash);
+		timing.cacheMs = elapsedMs(start);
+		timing.nbPrograms = 1;
+		timing.nbCached = this->ID != 0 ? 1 : 0;
+
+		if (this->ID == 0)
+			compile(vertexCode, fragmentCode);
+
+		if (wait)
+			finish();
+	}
+	// Uses the current shader
+	void Use()
+	{
+		glUseProgram(this->ID);
+	}
+
+	// Ainda falta o finish()
+	bool isPending() const { return pending; }
+
+	// true se o finish() nao vai precisar esperar. Sem GL_KHR_parallel_shader_compile
+	// nao da para saber sem bloquear: false ate o finish()
+	bool isComplete() const
+	{
+		if (!pending || vertex == 0)
+			return true;
+		if (!GLAD_GL_KHR_parallel_shader_compile)
+			return false;
+
+		GLint complete = GL_FALSE;
+		glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &complete);
+		return complete == GL_TRUE;
+	}
+
+	// Espera a compilacao e o link, mostra os erros e monta a tabela de uniforms.
+	// Retorna false se o link falhou
+	bool finish()
+	{
+		if (!pending)
+			return linked;
+		pending = false;
+
+		linked = true;
+		if (vertex != 0)
+		{
+			// Print compile and linking errors if any
+			Clock::time_point start = Clock::now();
+			checkCompile(vertex, "VERTEX");
+			checkCompile(fragment, "FRAGMENT");
+			linked = checkLink();
+			timing.waitMs = elapsedMs(start);
+
+			// Delete the shaders as they're linked into our program now and no longer necessery
+			glDeleteShader(vertex);
+			glDeleteShader(fragment);
+			vertex = fragment = 0;
+
+			if (linked)
+			{
+				start = Clock::now();
+				ProgramCache().save(ID, cacheName, sourceHash);
+				timing.cacheMs += elapsedMs(start);
+			}
+		}
+
+		ShaderTiming& total = getTotalTiming();
+		total.readMs += timing.readMs;
+		total.compileMs += timing.compileMs;
+		total.linkMs += timing.linkMs;
+		total.waitMs += timing.waitMs;
+		total.cacheMs += timing.cacheMs;
+		total.nbPrograms += timing.nbPrograms;
+		total.nbCached += timing.nbCached;
+
+		reflectUniforms();
+		return linked;
+	}
+
+	// Handle de um uniform, para usar nos set* sem procurar pelo nome a cada frame
+	UniformHandle getUniform(const std::string& name) const
+	{
+		// Poucos uniforms por programa: a busca linear basta
+		for (size_t i = 0; i < uniforms.size(); i++)
+		{
+			if (uniforms[i].name == name)
+				return (UniformHandle)i;
+		}
+		return -1;
+	}
+
+	// Os set* so chamam glUniform* quando o valor muda. Como antes, valem para o
+	// programa em uso (glUseProgram(ID)); quem chamar glUniform* direto deve chamar
+	// resetUniforms() depois.
+	void setBool(UniformHandle uniform, bool value)
+	{
+		setInt(uniform, (int)value);
+	}
+	// ------------------------------------------------------------------------
+	void setInt(UniformHandle uniform, int value)
+	{
+		if (update(uniform, &value, sizeof(value), GL_INT))
+			glUniform1i(uniforms[uniform].location, value);
+	}
+	// ------------------------------------------------------------------------
+	void setFloat(UniformHandle uniform, float value)
+	{
+		if (update(uniform, &value, sizeof(value), GL_FLOAT))
+			glUniform1f(uniforms[uniform].location, value);
+	}
+	// ------------------------------------------------------------------------
+	void setVec3(UniformHandle uniform, float v1, float v2, float v3)
+	{
+		GLfloat value[3] = { v1, v2, v3 };
+		if (update(uniform, value, sizeof(value), GL_FLOAT_VEC3))
+			glUniform3fv(uniforms[uniform].location, 1, value);
+	}
+
+	void setVec4(UniformHandle uniform, float v1, float v2, float v3, float v4)
+	{
+		GLfloat value[4] = { v1, v2, v3, v4 };
+		if (update(uniform, value, sizeof(value), GL_FLOAT_VEC4))
+			glUniform4fv(uniforms[uniform].location, 1, value);
+	}
+
+	void setMat4(UniformHandle uniform, const float* v)
+	{
+		if (update(uniform, v, 16 * sizeof(GLfloat), GL_FLOAT_MAT4))
+			glUniformMatrix4fv(uniforms[uniform].location, 1, GL_FALSE, v);
+	}
+
+	// Versoes pelo nome, para a configuracao inicial (sem glGetUniformLocation)
+	void setBool(const std::string& name, bool value) { setBool(getUniform(name), value); }
+	void setInt(const std::string& name, int value) { setInt(getUniform(name), value); }
+	void setFloat(const std::string& name, float value) { setFloat(getUniform(name), value); }
+	void setVec3(const std::string& name, float v1, float v2, float v3) { setVec3(getUniform(name), v1, v2, v3); }
+	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) { setVec4(getUniform(name), v1, v2, v3, v4); }
+	void setMat4(const std::string& name, const float* v) { setMat4(getUniform(name), v); }
+
+	// Esquece os valores guardados: o proximo set* de cada uniform sempre envia
+	void resetUniforms()
+	{
+		for (ShaderUniform& uniform : uniforms)
+			uniform.hasValue = false;
+	}
+
+	const vector<ShaderUniform>& getUniforms() const { return uniforms; }
+
+	// Liga o bloco de uniforms name ao ponto de ligacao binding (false se o programa nao
+	// usa o bloco)
+	bool bindUniformBlock(const std::string& name, GLuint binding)
+	{
+		GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+		if (index == GL_INVALID_INDEX)
+			return false;
+
+		glUniformBlockBinding(ID, index, binding);
+		return true;
+	}
+
+	// Tempos deste programa e a soma de todos os Shaders criados ate agora
+	const ShaderTiming& getTiming() const { return timing; }
+	static ShaderTiming& getTotalTiming()
+	{
+		static ShaderTiming total;
+		return total;
+	}
+
+protected:
+	typedef std::chrono::steady_clock Clock;
+
+	vector<ShaderUniform> uniforms;
+	ShaderTiming timing;
+
+	// Compilacao em andamento (estagios ainda nao apagados) ate o finish()
+	bool pending = true;
+	bool linked = false;
+	GLuint vertex = 0, fragment = 0;
+	string cacheName;
+	uint64_t sourceHash = 0;
+
+	static double elapsedMs(Clock::time_point from)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+	}
+
+	// O #version tem que ser a primeira linha: os defines vao depois dele, e o #line
+	// devolve a numeracao do arquivo para as mensagens de erro
+	static string insertDefines(const string& code, const string& defines)
+	{
+		if (code.compare(0, 8, "#version") != 0)
+			return defines + code;
+
+		size_t lineEnd = code.find('\n');
+		if (lineEnd == string::npos)
+			return code + "\n" + defines;
+
+		return code.substr(0, lineEnd + 1) + defines + "#line 2\n" + code.substr(lineEnd + 1);
+	}
+
+	// Manda compilar e linkar os fontes em ID, sem consultar o status (que faria a
+	// chamada esperar o driver terminar)
+	void compile(const std::string& vertexCode, const std::string& fragmentCode)
+	{
 		const GLchar* vShaderCode = vertexCode.c_str();
 		const GLchar * fShaderCode = fragmentCode.c_str();
 		// 2. Compile shaders
-		GLuint vertex, fragment;
-		GLint success;
-		GLchar infoLog[512];
+		Clock::time_point start = Clock::now();
 		// Vertex Shader
 		vertex = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vertex, 1, &vShaderCode, NULL);
 		glCompileShader(vertex);
-		// Print compile errors if any
-		glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
 		// Fragment Shader
 		fragment = glCreateShader(GL_FRAGMENT_SHADER);
 		glShaderSource(fragment, 1, &fShaderCode, NULL);
 		glCompileShader(fragment);
-		// Print compile errors if any
-		glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
+		timing.compileMs = elapsedMs(start);
 		// Shader Program
+		start = Clock::now();
 		this->ID = glCreateProgram();
 		glAttachShader(this->ID, vertex);
 		glAttachShader(this->ID, fragment);
+		if (ProgramCache::isSupported())
+			glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		glLinkProgram(this->ID);
-		// Print linking errors if any
+		timing.linkMs = elapsedMs(start);
+	}
+
+	// Status da compilacao de um estagio; mostra o log se falhou
+	bool checkCompile(GLuint shader, const char* stage)
+	{
+		GLint success;
+		GLchar infoLog[512];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+		}
+		return success != 0;
+	}
+
+	bool checkLink()
+	{
+		GLint success;
+		GLchar infoLog[512];
 		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
 		if (!success)
 		{
 			glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
 			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 		}
-		// Delete the shaders as they're linked into our program now and no longer necessery
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
-
-	}
-	// Uses the current shader
-	void Use()
-	{
-		glUseProgram(this->ID);
+		return success != 0;
 	}
 
-	void setBool(const std::string& name, bool value) const
+	// Tabela com os uniforms ativos (os que o compilador nao eliminou)
+	void reflectUniforms()
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
-	}
-	// ------------------------------------------------------------------------
-	void setInt(const std::string& name, int value) const
-	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
-	}
-	// ------------------------------------------------------------------------
-	void setFloat(const std::string& name, float value) const
-	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
-	}
-	// ------------------------------------------------------------------------
-	void setVec3(const std::string& name, float v1, float v2, float v3) const
-	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
-	}
+		GLint nbUniforms = 0, maxLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &nbUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
 
-	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
-	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		vector<GLchar> name(max(maxLength, 1));
+
+		for (GLint i = 0; i < nbUniforms; i++)
+		{
+			GLint size;
+			GLenum type;
+			glGetActiveUniform(ID, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+
+			ShaderUniform uniform;
+			uniform.name = name.data();
+			uniform.type = type;
+			uniform.location = glGetUniformLocation(ID, name.data());
+			uniform.hasValue = false;
+
+			// Uniforms em blocos nao tem localizacao
+			if (uniform.location < 0)
+				continue;
+
+			// Arrays aparecem como "nome[0]": os set* enviam so o primeiro elemento
+			size_t bracket = uniform.name.find('[');
+			if (bracket != string::npos)
+				uniform.name.resize(bracket);
+
+			uniforms.push_back(uniform);
+		}
 	}
 
-	void setMat4(const std::string& name, float *v) const
+	// Confere o tipo e guarda o valor; false quando nao ha nada a enviar
+	bool update(UniformHandle handle, const void* value, size_t size, GLenum type)
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		if (handle < 0 || handle >= (int)uniforms.size())
+			return false;
+
+		ShaderUniform& uniform = uniforms[handle];
+
+		// Samplers e bools sao enviados com glUniform1i
+		bool intLike = uniform.type == GL_INT || uniform.type == GL_BOOL || uniform.type == GL_SAMPLER_2D || uniform.type == GL_SAMPLER_CUBE;
+		if (uniform.type != type && !(type == GL_INT && intLike))
+		{
+			std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << uniform.name << std::endl;
+			return false;
+		}
+
+		if (uniform.hasValue && memcmp(uniform.value, value, size) == 0)
+			return false;
+
+		memcpy(uniform.value, value, size);
+		uniform.hasValue = true;
+		return true;
 	}
 };
 
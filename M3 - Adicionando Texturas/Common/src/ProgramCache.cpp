@@ -0,0 +1,140 @@
+#include "ProgramCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// Sem std::filesystem: os projetos dos modulos anteriores compilam em C++14
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir(path, 0755)
+#endif
+
+bool ProgramCache::enabled = true;
+
+static const char MAGIC[4] = { 'P', 'R', 'G', 'C' };
+
+static uint64_t hashString(const string& value, uint64_t hash = 14695981039346656037ull)
+{
+	for (unsigned char c : value)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64_t ProgramCache::hashSources(const string& vertexCode, const string& fragmentCode)
+{
+	// O '\0' separa os fontes: "ab" + "c" nao pode dar o mesmo hash que "a" + "bc"
+	return hashString(fragmentCode, hashString(string(1, '\0'), hashString(vertexCode)));
+}
+
+uint64_t ProgramCache::getDriverHash()
+{
+	// Um binario so vale para o mesmo driver: qualquer atualizacao muda GL_VERSION
+	string driver;
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		const char* value = (const char*)glGetString(name);
+		driver += value ? value : "";
+		driver += '\n';
+	}
+	return hashString(driver);
+}
+
+string ProgramCache::getCachePath(const string& name) const
+{
+	char file[32];
+	snprintf(file, sizeof(file), "%016llx.program", (unsigned long long)hashString(name));
+	return cacheDir + file;
+}
+
+GLuint ProgramCache::load(const string& name, uint64_t sourceHash)
+{
+	if (!isSupported())
+		return 0;
+
+	ifstream file(getCachePath(name), ios::binary);
+	if (!file.is_open())
+		return 0;
+
+	ProgramCacheHeader header;
+	if (!file.read((char*)&header, sizeof(header))
+		|| memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header.version != VERSION
+		|| header.sourceHash != sourceHash
+		|| header.driverHash != getDriverHash())
+	{
+		return 0;
+	}
+
+	vector<char> binary(header.binarySize);
+	if (!file.read(binary.data(), binary.size()))
+		return 0;
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+	// Recusado pelo driver (mesmo driver, mas por exemplo outra configuracao)
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+bool ProgramCache::save(GLuint program, const string& name, uint64_t sourceHash)
+{
+	if (!isSupported())
+		return false;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	vector<char> binary(length);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+	ProgramCacheHeader header;
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sourceHash = sourceHash;
+	header.driverHash = getDriverHash();
+	header.binaryFormat = binaryFormat;
+	header.binarySize = (uint32_t)length;
+
+	makeDirectory(cacheDir.c_str());
+
+	// Grava num arquivo temporario e renomeia, para nunca deixar um programa pela metade
+	string cachePath = getCachePath(name);
+	string tempPath = cachePath + ".tmp";
+
+	ofstream cacheFile(tempPath, ios::binary | ios::trunc);
+	if (!cacheFile.is_open())
+		return false;
+
+	cacheFile.write((const char*)&header, sizeof(header));
+	cacheFile.write(binary.data(), length);
+	cacheFile.close();
+
+	if (!cacheFile)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	// No Windows o rename nao substitui um arquivo existente
+	remove(cachePath.c_str());
+	return rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <cmath>
 #include <vector>
+#include <unordered_map>
 
 using namespace std;
 
@@ -13,9 +14,10 @@ using namespace std;
 #include <glm/gtc/type_ptr.hpp>
 #include "stb_image.h"
 #include "Shader.h"
+#include "MeshOptimizer.h"
 
 int loadTexture(string path);
-int loadObj(string filepath, int& nVerts, glm::vec3 color);
+int loadObj(string filepath, int& nIndices, glm::vec3 color);
 
 const GLuint WIDTH = 800, HEIGHT = 600;
 
@@ -30,6 +32,8 @@ int main()
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
 	}
+	// Funcoes alem da 3.3 (cache de programas do Shader), quando o driver tem
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
 	const GLubyte* version = glGetString(GL_VERSION); /* version as a string */
@@ -42,16 +46,17 @@ int main()
 	GLuint texID = loadTexture("SuzanneTriTextured.mtl");
 
 	// Gerando uma geometria de quadriltero com coordenadas de textura
-	int nVerts;
-	GLuint VAO = loadObj("SuzanneTriTextured.obj", nVerts,glm::vec3(0,0,0));
+	int nIndices;
+	GLuint VAO = loadObj("SuzanneTriTextured.obj", nIndices,glm::vec3(0,0,0));
 
 	glUseProgram(shader.ID);
-	glUniform1i(glGetUniformLocation(shader.ID, "tex_buffer"), 0);
+	shader.setInt("tex_buffer", 0);
 	glm::mat4 projection = glm::mat4(1); //matriz identidade
 	projection = glm::ortho(-3.0, 3.0, -3.0, 3.0, -1.0, 1.0);
 
-	GLint projLoc = glGetUniformLocation(shader.ID, "projection");
-	glUniformMatrix4fv(projLoc, 1, FALSE, glm::value_ptr(projection));
+	shader.setMat4("projection", glm::value_ptr(projection));
+
+	UniformHandle modelUniform = shader.getUniform("model");
 
 	glEnable(GL_DEPTH_TEST);
 
@@ -71,14 +76,13 @@ int main()
 
 		glm::mat4 model = glm::mat4(1);
 		model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(0, 1, 0));
-		GLint modelLoc = glGetUniformLocation(shader.ID, "model");
-		glUniformMatrix4fv(modelLoc, 1, FALSE, glm::value_ptr(model));
+		shader.setMat4(modelUniform, glm::value_ptr(model));
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, texID);
 
 		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, nVerts);
+		glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_INT, 0);
 		
 		glBindVertexArray(0);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -146,13 +150,14 @@ int loadTexture(string mtlFilePath)
 	return texID;
 }
 
-int loadObj(string filepath, int& nVerts, glm::vec3 color)
+int loadObj(string filepath, int& nIndices, glm::vec3 color)
 {
 	vector <glm::vec3> vertices;
 	vector <GLuint> indices;
 	vector <glm::vec2> texCoords;
 	vector <glm::vec3> normals;
 	vector <GLfloat> vbuffer;
+	unordered_map <uint64_t, GLuint> uniqueVertices;
 
 	ifstream inputFile;
 	inputFile.open(filepath.c_str());
@@ -203,29 +208,42 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 					//Recuperando os indices de v
 					int pos = tokens[i].find("/");
 					string token = tokens[i].substr(0, pos);
-					int index = atoi(token.c_str()) - 1;
-					indices.push_back(index);
-
-					vbuffer.push_back(vertices[index].x);
-					vbuffer.push_back(vertices[index].y);
-					vbuffer.push_back(vertices[index].z);
-					vbuffer.push_back(color.r);
-					vbuffer.push_back(color.g);
-					vbuffer.push_back(color.b);
+					int vIndex = atoi(token.c_str()) - 1;
 
 					//Recuperando os indices de vts
 					tokens[i] = tokens[i].substr(pos + 1);
 					pos = tokens[i].find("/");
 					token = tokens[i].substr(0, pos);
-					index = atoi(token.c_str()) - 1;
-					vbuffer.push_back(texCoords[index].s);
-					vbuffer.push_back(texCoords[index].t);
+					int tIndex = atoi(token.c_str()) - 1;
+
 					//Recuperando os indices de vns
 					tokens[i] = tokens[i].substr(pos + 1);
-					index = atoi(tokens[i].c_str()) - 1;
-					vbuffer.push_back(normals[index].x);
-					vbuffer.push_back(normals[index].y);
-					vbuffer.push_back(normals[index].z);
+					int nIndex = atoi(tokens[i].c_str()) - 1;
+
+					//Se a tripla v/vt/vn ja apareceu, reaproveita o vertice pelo indice
+					uint64_t key = ((uint64_t)vIndex << 42) | ((uint64_t)tIndex << 21) | (uint64_t)nIndex;
+					auto found = uniqueVertices.find(key);
+					if (found != uniqueVertices.end())
+					{
+						indices.push_back(found->second);
+						continue;
+					}
+
+					GLuint index = vbuffer.size() / 11;
+					uniqueVertices[key] = index;
+					indices.push_back(index);
+
+					vbuffer.push_back(vertices[vIndex].x);
+					vbuffer.push_back(vertices[vIndex].y);
+					vbuffer.push_back(vertices[vIndex].z);
+					vbuffer.push_back(color.r);
+					vbuffer.push_back(color.g);
+					vbuffer.push_back(color.b);
+					vbuffer.push_back(texCoords[tIndex].s);
+					vbuffer.push_back(texCoords[tIndex].t);
+					vbuffer.push_back(normals[nIndex].x);
+					vbuffer.push_back(normals[nIndex].y);
+					vbuffer.push_back(normals[nIndex].z);
 				}
 			}
 		}
@@ -235,8 +253,17 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 		cout << "Problema ao encontrar o arquivo " << filepath << endl;
 	}
 	inputFile.close();
-	GLuint VBO, VAO;
-	nVerts = vbuffer.size() / 11; // 3 pos + 3 cor + 3 normal + 2 texcoord
+
+	//Reordena triangulos e vertices para o cache de vertices e o overdraw
+	MeshOptimizerStats stats;
+	size_t nbVertices = optimizeMesh(vbuffer.data(), vbuffer.size() / 11, 11 * sizeof(GLfloat), indices.data(), indices.size(), {},
+		vbuffer.data(), 11 * sizeof(GLfloat), stats);
+	vbuffer.resize(nbVertices * 11);
+	cout << filepath << ": ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+		<< ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << endl;
+
+	GLuint VBO, EBO, VAO;
+	nIndices = indices.size(); // vbuffer: 3 pos + 3 cor + 3 normal + 2 texcoord por vertice unico
 	//Gerao do identificador do VBO
 	glGenBuffers(1, &VBO);
 	//Faz a conexo (vincula) do buffer como um buffer de array
@@ -248,6 +275,10 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vrtices
 	// e os ponteiros para os atributos 
 	glBindVertexArray(VAO);
+	//Indices dos triangulos - o EBO fica registrado no VAO
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando: 
 	// Localizao no shader * (a localizao dos atributos devem ser correspondentes no layout especificado no vertex shader)
 	// Numero de valores que o atributo tem (por ex, 3 coordenadas xyz) 
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+
+using namespace std;
+
+// Cabecalho do arquivo de programa; o binario do driver vem logo depois
+struct ProgramCacheHeader
+{
+	char magic[4];         // "PRGC"
+	uint32_t version;
+	uint64_t sourceHash;   // FNV-1a dos fontes dos shaders
+	uint64_t driverHash;   // FNV-1a de GL_VENDOR, GL_RENDERER e GL_VERSION
+	uint32_t binaryFormat;
+	uint32_t binarySize;
+};
+
+// Cache de programas ja linkados (glGetProgramBinary). Cada programa tem um arquivo em
+// cacheDir, que so e usado se os fontes e o driver forem os mesmos de quando foi gravado.
+// Mesmo assim o driver pode recusar o binario; nesse caso load() retorna 0 e o Shader
+// compila de novo (e regrava).
+class ProgramCache
+{
+public:
+	static const uint32_t VERSION = 1;
+
+	// Desliga o cache para todos os Shaders (para medir a compilacao)
+	static bool enabled;
+
+	ProgramCache(const string& cacheDir = "../cache/") : cacheDir(cacheDir) {}
+
+	// Precisa do loadGLExtensions e de um driver com algum formato binario
+	static bool isSupported() { return enabled && GLAD_GL_ARB_get_program_binary; }
+
+	static uint64_t hashSources(const string& vertexCode, const string& fragmentCode);
+
+	// Programa novo a partir do binario de name (ex.: os caminhos dos shaders), ou 0
+	GLuint load(const string& name, uint64_t sourceHash);
+
+	// Grava o binario de program; ele precisa ter sido linkado com
+	// GL_PROGRAM_BINARY_RETRIEVABLE_HINT ligado
+	bool save(GLuint program, const string& name, uint64_t sourceHash);
+
+protected:
+	string cacheDir;
+
+	string getCachePath(const string& name) const;
+	static uint64_t getDriverHash();
+};
@@ -0,0 +1,30 @@
+#include "FrameUniforms.h"
+
+#include <cstring>
+
+// Espaco do bloco no comeco da regiao, com folga para o alinhamento do glBindBufferRange
+static GLsizeiptr getFrameDataSize()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return ((GLsizeiptr)sizeof(FrameData) + alignment - 1) / alignment * alignment;
+}
+
+FrameUniforms::FrameUniforms(GLsizeiptr dynamicSize)
+	: ring(getFrameDataSize() + dynamicSize)
+{
+	data = FrameData();
+}
+
+void FrameUniforms::upload()
+{
+	ring.beginFrame();
+
+	// Primeira alocacao do frame: fica no inicio da regiao, que ja comeca alinhada
+	GLintptr offset = 0;
+	void* block = ring.allocate(sizeof(FrameData), ring.getUniformAlignment(), offset);
+	memcpy(block, &data, sizeof(FrameData));
+	ring.flush();
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, ring.getBuffer(), offset, sizeof(FrameData));
+}
@@ -0,0 +1,128 @@
+#include "RingBuffer.h"
+
+static void waitFence(GLsync& fence)
+{
+	if (!fence)
+		return;
+
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+RingBuffer::RingBuffer(GLsizeiptr frameSize)
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	uniformAlignment = alignment;
+
+	// Cada regiao comeca num multiplo do alinhamento: serve para qualquer bloco de uniforms
+	this->frameSize = (frameSize + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+	createBuffer();
+}
+
+RingBuffer::~RingBuffer()
+{
+	deleteBuffer();
+}
+
+void RingBuffer::createBuffer()
+{
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+	if (GLAD_GL_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, frameSize * RING_BUFFER_FRAMES, nullptr, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frameSize * RING_BUFFER_FRAMES, flags);
+	}
+
+	if (!mapped)
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, frameSize * RING_BUFFER_FRAMES, nullptr, GL_DYNAMIC_DRAW);
+		staging.resize(frameSize);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	region = 0;
+	used = flushed = 0;
+}
+
+void RingBuffer::deleteBuffer()
+{
+	for (GLsync& fence : fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	if (mapped)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		mapped = nullptr;
+	}
+
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+void RingBuffer::reserve(GLsizeiptr frameSize)
+{
+	if (frameSize <= this->frameSize)
+		return;
+
+	// Nenhuma regiao pode estar sendo lida quando o buffer for apagado
+	for (GLsync& fence : fences)
+		waitFence(fence);
+	deleteBuffer();
+
+	this->frameSize = (frameSize + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+	createBuffer();
+}
+
+void RingBuffer::beginFrame()
+{
+	if (mapped)
+	{
+		// Os comandos ate aqui (o frame anterior) leem a regiao atual: a fence marca o fim deles
+		if (fences[region])
+			glDeleteSync(fences[region]);
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	region = (region + 1) % RING_BUFFER_FRAMES;
+	used = flushed = 0;
+
+	// So espera se a GPU estiver RING_BUFFER_FRAMES frames atrasada
+	waitFence(fences[region]);
+}
+
+void* RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset)
+{
+	GLsizeiptr start = (used + alignment - 1) / alignment * alignment;
+	if (start + size > frameSize)
+		return nullptr;
+
+	used = start + size;
+	offset = region * frameSize + start;
+
+	return mapped ? mapped + offset : staging.data() + start;
+}
+
+void RingBuffer::flush()
+{
+	if (mapped || flushed == used)
+		return;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, region * frameSize + flushed, used - flushed, staging.data() + flushed);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	flushed = used;
+}
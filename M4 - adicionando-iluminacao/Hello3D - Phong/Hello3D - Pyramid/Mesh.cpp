@@ -1,9 +1,9 @@
 #include "Mesh.h"
 
-void Mesh::initialize(GLuint VAO, int nVertices, Shader* shader, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis)
+void Mesh::initialize(GLuint VAO, int nIndices, Shader* shader, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis)
 {
 	this->VAO = VAO;
-	this->nVertices = nVertices;
+	this->nIndices = nIndices;
 	this->shader = shader;
 	this->position = position;
 	this->scale = scale;
@@ -23,6 +23,6 @@ void Mesh::update()
 void Mesh::draw()
 {
 	glBindVertexArray(VAO);
-	glDrawArrays(GL_TRIANGLES, 0, nVertices);
+	glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_INT, 0);
 	glBindVertexArray(0);
 }
@@ -13,13 +13,13 @@ class Mesh
 public:
 	Mesh() {}
 	~Mesh() {}
-	void initialize(GLuint VAO, int nVertices, Shader* shader, glm::vec3 position = glm::vec3(0.0, 0.0, 0.0), glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
+	void initialize(GLuint VAO, int nIndices, Shader* shader, glm::vec3 position = glm::vec3(0.0, 0.0, 0.0), glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
 	void update();
 	void draw();
 
 protected:
 	GLuint VAO; //Identificador do Vertex Array Object - Vrtices e seus atributos
-	int nVertices;
+	int nIndices; //Quantidade de indices no EBO vinculado ao VAO
 
 	//Informaes sobre as transformaes a serem aplicadas no objeto
 	glm::vec3 position;
@@ -2,6 +2,7 @@
 #include <string>
 #include <assert.h>
 #include <vector>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 
@@ -13,6 +14,8 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "Shader.h"
+#include "FrameUniforms.h"
+#include "MeshOptimizer.h"
 #include "Mesh.h"
 #include "stb_image.h"
 
@@ -26,7 +29,7 @@ struct Material {
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 int loadTexture(string path);
-int loadObj(string filepath, int &nVerts, glm::vec3 color = glm::vec3(1.0,0.0,1.0));
+int loadObj(string filepath, int &nIndices, glm::vec3 color = glm::vec3(1.0,0.0,1.0));
 Material loadMaterial(string filename);
 
 bool rotateX=false, rotateY=false, rotateZ=false;
@@ -45,6 +48,7 @@ int main()
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
 	}
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 	// Obtendo as informações de versão
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -63,13 +67,18 @@ int main()
 
 	glUseProgram(shader.ID);
 
+	// Camera e luz ficam no bloco FrameData, enviado uma vez por frame
+	FrameUniforms* frameUniforms = new FrameUniforms();
+	shader.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+
 	//Matriz de view -- posição e orientação da câmera
 	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
-	shader.setMat4("view",value_ptr(view));
+	frameUniforms->data.view = view;
+	frameUniforms->data.cameraPos = glm::vec4(0.0, 0.0, 3.0, 1.0);
 
 	//Matriz de projeção perspectiva - definindo o volume de visualização (frustum)
 	glm::mat4 projection = glm::perspective(glm::radians(80.0f), (float)width / (float)height, 0.1f, 100.0f);
-	shader.setMat4("projection", glm::value_ptr(projection));
+	frameUniforms->data.projection = projection;
 
 	glEnable(GL_DEPTH_TEST);
 
@@ -80,11 +89,11 @@ int main()
 	GLuint texID = loadTexture("SuzanneTriTextured.mtl");
 
 	//Carregando OBJ
-	int nVerts;
-	GLuint VAO = loadObj("../../3D_models/Suzanne/suzanneTriLowPoly.obj", nVerts);
+	int nIndices;
+	GLuint VAO = loadObj("../../3D_models/Suzanne/suzanneTriLowPoly.obj", nIndices);
 
 	Mesh suzanne;
-	suzanne.initialize(VAO, nVerts, &shader);
+	suzanne.initialize(VAO, nIndices, &shader);
 
 	// Definir as propriedades do material da superfície
 	shader.setVec3("ka", material.ka.r, material.ka.g, material.ka.b);
@@ -94,8 +103,8 @@ int main()
 
 	//Definindo a fonte de luz pontual
   // Definindo as propriedades da fonte de luz
-	shader.setVec3("lightPosition", 15.0f, 15.0f, 2.0f);
-	shader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+	frameUniforms->data.lightPos = glm::vec4(15.0f, 15.0f, 2.0f, 1.0f);
+	frameUniforms->data.lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
@@ -114,6 +123,8 @@ int main()
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, texID);
 
+		frameUniforms->upload();
+
 		// Chamada de desenho - drawcall
 		shader.setFloat("q", 10.0);
 		suzanne.update();
@@ -123,6 +134,8 @@ int main()
 	}
 	// Pede pra OpenGL desalocar os buffers
 	glDeleteVertexArrays(1, &VAO);
+	// Antes do glfwTerminate, enquanto o contexto ainda existe
+	delete frameUniforms;
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
@@ -260,13 +273,14 @@ int loadTexture(string mtlFilePath)
 	return texID;
 }
 
-int loadObj(string filepath, int& nVerts, glm::vec3 color)
+int loadObj(string filepath, int& nIndices, glm::vec3 color)
 {
 	vector <glm::vec3> vertices;
 	vector <GLuint> indices;
 	vector <glm::vec2> texCoords;
 	vector <glm::vec3> normals;
 	vector <GLfloat> vbuffer;
+	unordered_map <uint64_t, GLuint> uniqueVertices;
 
 	ifstream inputFile;
 	inputFile.open(filepath.c_str());
@@ -317,29 +331,42 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 					//Recuperando os indices de v
 					int pos = tokens[i].find("/");
 					string token = tokens[i].substr(0, pos);
-					int index = atoi(token.c_str()) - 1;
-					indices.push_back(index);
-
-					vbuffer.push_back(vertices[index].x);
-					vbuffer.push_back(vertices[index].y);
-					vbuffer.push_back(vertices[index].z);
-					vbuffer.push_back(color.r);
-					vbuffer.push_back(color.g);
-					vbuffer.push_back(color.b);
+					int vIndex = atoi(token.c_str()) - 1;
 
 					//Recuperando os indices de vts
 					tokens[i] = tokens[i].substr(pos + 1);
 					pos = tokens[i].find("/");
 					token = tokens[i].substr(0, pos);
-					index = atoi(token.c_str()) - 1;
-					vbuffer.push_back(texCoords[index].s);
-					vbuffer.push_back(texCoords[index].t);
+					int tIndex = atoi(token.c_str()) - 1;
+
 					//Recuperando os indices de vns
 					tokens[i] = tokens[i].substr(pos + 1);
-					index = atoi(tokens[i].c_str()) - 1;
-					vbuffer.push_back(normals[index].x);
-					vbuffer.push_back(normals[index].y);
-					vbuffer.push_back(normals[index].z);
+					int nIndex = atoi(tokens[i].c_str()) - 1;
+
+					//Se a tripla v/vt/vn ja apareceu, reaproveita o vertice pelo indice
+					uint64_t key = ((uint64_t)vIndex << 42) | ((uint64_t)tIndex << 21) | (uint64_t)nIndex;
+					auto found = uniqueVertices.find(key);
+					if (found != uniqueVertices.end())
+					{
+						indices.push_back(found->second);
+						continue;
+					}
+
+					GLuint index = vbuffer.size() / 11;
+					uniqueVertices[key] = index;
+					indices.push_back(index);
+
+					vbuffer.push_back(vertices[vIndex].x);
+					vbuffer.push_back(vertices[vIndex].y);
+					vbuffer.push_back(vertices[vIndex].z);
+					vbuffer.push_back(color.r);
+					vbuffer.push_back(color.g);
+					vbuffer.push_back(color.b);
+					vbuffer.push_back(texCoords[tIndex].s);
+					vbuffer.push_back(texCoords[tIndex].t);
+					vbuffer.push_back(normals[nIndex].x);
+					vbuffer.push_back(normals[nIndex].y);
+					vbuffer.push_back(normals[nIndex].z);
 				}
 			}
 		}
@@ -349,8 +376,17 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 		cout << "Problema ao encontrar o arquivo " << filepath << endl;
 	}
 	inputFile.close();
-	GLuint VBO, VAO;
-	nVerts = vbuffer.size() / 11; // 3 pos + 3 cor + 3 normal + 2 texcoord
+
+	//Reordena triangulos e vertices para o cache de vertices e o overdraw
+	MeshOptimizerStats stats;
+	size_t nbVertices = optimizeMesh(vbuffer.data(), vbuffer.size() / 11, 11 * sizeof(GLfloat), indices.data(), indices.size(), {},
+		vbuffer.data(), 11 * sizeof(GLfloat), stats);
+	vbuffer.resize(nbVertices * 11);
+	cout << filepath << ": ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+		<< ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << endl;
+
+	GLuint VBO, EBO, VAO;
+	nIndices = indices.size(); // vbuffer: 3 pos + 3 cor + 3 normal + 2 texcoord por vertice unico
 	//Gera��o do identificador do VBO
 	glGenBuffers(1, &VBO);
 	//Faz a conex�o (vincula) do buffer como um buffer de array
@@ -362,6 +398,10 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de v�rtices
 	// e os ponteiros para os atributos 
 	glBindVertexArray(VAO);
+	//Indices dos triangulos - o EBO fica registrado no VAO
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando: 
 	// Localiza��o no shader * (a localiza��o dos atributos devem ser correspondentes no layout especificado no vertex shader)
 	// Numero de valores que o atributo tem (por ex, 3 coordenadas xyz) 
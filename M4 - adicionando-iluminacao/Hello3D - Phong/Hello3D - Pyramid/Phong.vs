@@ -8,8 +8,16 @@ layout (location = 3) in vec3 normal;
 
 // Declara as variáveis uniformes do shader
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Camera e luz, compartilhadas por frame (FrameUniforms.h)
+layout(std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
 
 // Declara as variáveis de saída (outputs) do shader
 out vec3 finalColor;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Volumes envolventes dos objetos no mundo, em estrutura de arrays: o teste do frustum
+// le 4 objetos de cada vez com uma instrucao SSE por componente
+struct BoundsArray
+{
+	vector<float> centerX, centerY, centerZ; // centro da AABB (tambem centro da esfera)
+	vector<float> extentX, extentY, extentZ; // metade do tamanho da AABB
+	vector<float> radius;                    // raio da esfera
+
+	size_t size() const { return radius.size(); }
+	void clear();
+	void add(glm::vec3 center, glm::vec3 extents, float radius);
+};
+
+// Frustum da camera. Um objeto fica de fora quando esta inteiro atras de algum plano;
+// a distancia que ele avanca na direcao do plano e a menor entre a da AABB e a da
+// esfera (as duas envolvem o objeto, entao vale a mais justa).
+class FrustumCuller
+{
+public:
+	// projection * view: os planos saem no espaco do mundo
+	void setup(const glm::mat4& projectionView);
+
+	// visible[i] = 1 se o objeto i pode aparecer; retorna quantos podem
+	size_t cull(const BoundsArray& bounds, vector<unsigned char>& visible) const;
+
+	bool isVisible(glm::vec3 center, glm::vec3 extents, float radius) const;
+
+protected:
+	glm::vec4 planes[6]; // dentro: dot(xyz, p) + w >= 0, com xyz normalizado
+};
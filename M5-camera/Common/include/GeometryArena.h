@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+using namespace std;
+
+// Faixa de indices de uma malha dentro da arena
+struct ArenaMesh
+{
+	GLuint firstIndex = 0;
+	GLuint nIndices = 0;
+};
+
+// Vertices e indices de todas as malhas estaticas num VBO e num EBO so, com um unico VAO.
+// Os indices de cada malha sao somados ao primeiro vertice dela na arena, entao desenhar
+// uma malha e so escolher a faixa de indices (sem baseVertex nem troca de VAO).
+class GeometryArena
+{
+public:
+	// vertexSize em bytes. As capacidades (em vertices e indices) dobram quando faltam
+	GeometryArena(GLsizei vertexSize, size_t vertexCapacity = 1 << 16, size_t indexCapacity = 1 << 18);
+	~GeometryArena();
+	GeometryArena(const GeometryArena&) = delete;
+	GeometryArena& operator=(const GeometryArena&) = delete;
+
+	// Atributo de floats do vertice: size componentes a partir de offset bytes
+	void addAttribute(GLuint location, GLint size, size_t offset);
+
+	// Copia a malha para o fim dos buffers. indices comecam em 0 (o primeiro vertice da malha)
+	ArenaMesh add(const void* vertices, size_t nVertices, const GLuint* indices, size_t nIndices);
+
+	GLuint getVAO() const { return VAO; }
+	size_t getNbVertices() const { return nbVertices; }
+	size_t getNbIndices() const { return nbIndices; }
+
+protected:
+	struct Attribute
+	{
+		GLuint location;
+		GLint size;
+		size_t offset;
+	};
+
+	GLsizei vertexSize;
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	size_t vertexCapacity, indexCapacity;
+	size_t nbVertices = 0, nbIndices = 0;
+	vector<Attribute> attributes;
+
+	// Troca o buffer por um de newSize bytes, copiando os usedSize primeiros na GPU
+	static void grow(GLuint& buffer, GLsizeiptr usedSize, GLsizeiptr newSize);
+	// Aponta o VAO para o VBO e o EBO atuais (de novo depois de um grow)
+	void setupVAO();
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Tamanho do cache de vertices pos-transformacao simulado (FIFO). 16 e conservador:
+// as GPUs atuais guardam pelo menos isso, entao a ordem tambem serve para elas.
+const int VERTEX_CACHE_SIZE = 16;
+
+// Piora maxima do ACMR aceita pela otimizacao de overdraw (1.05 = 5%)
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+// Eficiencia do cache de vertices para uma ordem de indices
+struct VertexCacheStats
+{
+	size_t nbTransformed = 0; // faltas no cache = vertices que passam pelo vertex shader
+	float acmr = 0.0f;        // faltas por triangulo (0.5 ~ otimo, 3 = sem reuso)
+	float atvr = 0.0f;        // faltas por vertice usado (1 = otimo)
+};
+
+struct MeshOptimizerStats
+{
+	VertexCacheStats before;
+	VertexCacheStats after;
+};
+
+// Faixa de indices [first, first + count) otimizada sozinha: os triangulos nunca saem
+// da faixa, entao as submeshes (uma faixa por material) continuam valendo
+struct IndexRange
+{
+	size_t first;
+	size_t count;
+};
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t nbIndices, size_t nbVertices, int cacheSize = VERTEX_CACHE_SIZE);
+
+// Reordena os triangulos para reusar o cache de vertices (Tipsify, Sander et al. 2007)
+void optimizeVertexCache(unsigned int* indices, size_t nbIndices, size_t nbVertices, int cacheSize = VERTEX_CACHE_SIZE);
+
+// Depois do optimizeVertexCache: divide os triangulos em grupos que quase nao pioram o
+// cache e desenha primeiro os grupos voltados para fora da malha, que tendem a cobrir
+// os outros (menos fragmentos sombreados a toa com o teste de profundidade).
+// positions: xyz em float do vertice 0; positionStride em bytes.
+void optimizeOverdraw(unsigned int* indices, size_t nbIndices, const float* positions, size_t positionStride, size_t nbVertices,
+	float threshold = OVERDRAW_THRESHOLD, int cacheSize = VERTEX_CACHE_SIZE);
+
+// Renumera os vertices na ordem em que os indices os usam pela primeira vez (leitura
+// sequencial do VBO) e reordena vertices no lugar. Vertices nao usados vao para o fim;
+// retorna quantos sao usados.
+size_t optimizeVertexFetch(void* vertices, size_t nbVertices, size_t stride, unsigned int* indices, size_t nbIndices);
+
+// Passa completa do pipeline de malhas: cache de vertices e overdraw em cada faixa
+// (ranges vazio = a malha inteira), depois a ordem dos vertices. positions pode apontar
+// para dentro de vertices; se for um array separado, tambem e reordenado.
+// Retorna o numero de vertices usados.
+size_t optimizeMesh(void* vertices, size_t nbVertices, size_t stride, unsigned int* indices, size_t nbIndices,
+	const vector<IndexRange>& ranges, float* positions, size_t positionStride, MeshOptimizerStats& stats);
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glad/glad.h>
+
+using namespace std;
+
+// Unidades de textura que um comando pode usar (0 = cor, 1 = normal map)
+const int RENDER_TEXTURE_UNITS = 2;
+
+// Uma chamada de desenho e o estado de que ela precisa. Com nbRanges > 0 desenha as
+// faixas de indices da fila (glMultiDrawElements); senao, count indices a partir de
+// first (ou count vertices, com indexed = false)
+struct DrawCommand
+{
+	uint64_t key = 0;
+	GLuint program = 0;
+	GLuint VAO = 0;
+	GLuint textures[RENDER_TEXTURE_UNITS] = {}; // 0 = unidade nao usada
+	GLenum mode = GL_TRIANGLES;
+	bool indexed = true;
+	GLuint first = 0;
+	GLsizei count = 0;
+	uint32_t firstRange = 0, nbRanges = 0;      // preenchidos pelo submit()
+	const void* data = nullptr;                 // de quem submeteu (material, objeto...)
+};
+
+// Trocas de estado do ultimo execute(). requested conta um bind de programa, VAO e de
+// cada textura por comando, como cada chamada de desenho fazia antes da fila
+struct RenderQueueStats
+{
+	int nbCommands = 0;
+	int nbRequested = 0;
+	int programChanges = 0;
+	int textureChanges = 0;
+	int vaoChanges = 0;
+
+	int getStateChanges() const { return programChanges + textureChanges + vaoChanges; }
+};
+
+// Fila de desenho do frame: os comandos sao ordenados pela chave e executados sem repetir
+// o glUseProgram / glBindTexture / glBindVertexArray que ja estiver valendo
+class RenderQueue
+{
+public:
+	// Campos da chave, do mais significativo ao menos: passo, programa, material (textura),
+	// VAO e profundidade. Somam 64 bits
+	static const int PASS_BITS = 4, PROGRAM_BITS = 12, MATERIAL_BITS = 16, VAO_BITS = 12, DEPTH_BITS = 20;
+
+	// depth em [0, 1], 0 = perto (desenha de frente para tras dentro do mesmo estado).
+	// Os campos sao truncados nos seus bits: valores que caem juntos so mudam a ordem,
+	// nunca o estado usado no desenho
+	static uint64_t makeKey(unsigned pass, unsigned program, unsigned material, unsigned VAO, float depth);
+
+	void clear();
+	// Faixa de indices do proximo comando submetido
+	void addRange(GLsizei count, const void* offset);
+	// O comando fica com as faixas adicionadas desde o ultimo submit
+	void submit(const DrawCommand& command);
+	// Faixas esperando o proximo submit
+	uint32_t getNbPendingRanges() const { return (uint32_t)rangeCounts.size() - pendingRange; }
+	// Descarta as faixas pendentes (o comando nao vai ser submetido)
+	void dropPendingRanges();
+
+	// Radix sort das chaves: 8 bits por passada, do byte menos significativo ao mais,
+	// pulando os bytes que sao iguais em todas
+	void sort();
+	// Desenha na ordem do sort(); setup e chamado depois dos binds de cada comando, para
+	// os uniforms de quem submeteu. O estado de fora da fila e desconhecido: o primeiro
+	// comando sempre faz todos os binds
+	void execute(const function<void(const DrawCommand&)>& setup);
+
+	size_t size() const { return commands.size(); }
+	const RenderQueueStats& getStats() const { return stats; }
+
+protected:
+	vector<DrawCommand> commands;
+	vector<uint32_t> order, orderTemp; // indices de commands em ordem de chave
+	vector<GLsizei> rangeCounts;
+	vector<const void*> rangeOffsets;
+	uint32_t pendingRange = 0;
+	RenderQueueStats stats;
+};
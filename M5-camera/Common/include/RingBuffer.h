@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GLExtensions.h"
+
+using namespace std;
+
+// Regioes do anel: a CPU escreve a do frame N+2 enquanto a GPU ainda pode estar lendo a
+// do frame N
+const int RING_BUFFER_FRAMES = 3;
+
+// Dados dinamicos do frame (blocos de uniforms, matrizes por objeto, comandos indiretos)
+// num buffer com uma regiao por frame. Com GL_ARB_buffer_storage o buffer fica mapeado
+// (persistente e coerente) e as alocacoes sao escritas direto nele; a regiao so volta a
+// ser usada depois da fence de RING_BUFFER_FRAMES frames atras. Sem a extensao, as
+// alocacoes ficam numa copia na CPU e o flush() envia com glBufferSubData.
+class RingBuffer
+{
+public:
+	// frameSize: bytes por frame. Precisa de um contexto atual e do loadGLExtensions ja chamado
+	RingBuffer(GLsizeiptr frameSize);
+	~RingBuffer();
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	// Aumenta a regiao de cada frame para pelo menos frameSize bytes. Espera a GPU e troca
+	// o buffer: chamar entre frames, antes do beginFrame()
+	void reserve(GLsizeiptr frameSize);
+
+	// Passa para a regiao do proximo frame, esperando a GPU terminar de ler o que estava
+	// nela. Chamar uma vez por frame, antes das alocacoes
+	void beginFrame();
+
+	// size bytes na regiao do frame, comecando num multiplo de alignment. offset e a posicao
+	// no buffer (para glBindBufferRange, glVertexAttribPointer...). nullptr se nao couber
+	void* allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset);
+
+	// Envia o que foi escrito desde o ultimo flush (sem mapeamento; com ele, nao faz nada).
+	// Chamar antes dos desenhos que leem as alocacoes
+	void flush();
+
+	GLuint getBuffer() const { return buffer; }
+	GLsizeiptr getFrameSize() const { return frameSize; }
+	// Alinhamento de glBindBufferRange de uniforms (cada regiao comeca num multiplo dele)
+	GLsizeiptr getUniformAlignment() const { return uniformAlignment; }
+	bool isPersistent() const { return mapped != nullptr; }
+
+protected:
+	GLuint buffer = 0;
+	GLsizeiptr frameSize = 0;
+	GLsizeiptr uniformAlignment = 256;
+	unsigned char* mapped = nullptr;
+	vector<unsigned char> staging; // sem mapeamento: a regiao do frame, ate o flush()
+	GLsync fences[RING_BUFFER_FRAMES] = {};
+	int region = 0;
+	GLsizeiptr used = 0, flushed = 0;
+
+	void createBuffer();
+	void deleteBuffer();
+};
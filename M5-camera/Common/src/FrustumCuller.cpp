@@ -0,0 +1,112 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE em x86 (no Visual Studio 32 bits ele vem ligado por padrao, /arch:SSE2)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+void BoundsArray::clear()
+{
+	centerX.clear(); centerY.clear(); centerZ.clear();
+	extentX.clear(); extentY.clear(); extentZ.clear();
+	radius.clear();
+}
+
+void BoundsArray::add(glm::vec3 center, glm::vec3 extents, float radius)
+{
+	centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+	extentX.push_back(extents.x); extentY.push_back(extents.y); extentZ.push_back(extents.z);
+	this->radius.push_back(radius);
+}
+
+void FrustumCuller::setup(const glm::mat4& projectionView)
+{
+	// Planos tirados das linhas da matriz (Gribb e Hartmann)
+	const glm::mat4& m = projectionView;
+
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+		glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+		planes[i * 2] = w + row;
+		planes[i * 2 + 1] = w - row;
+	}
+
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+}
+
+bool FrustumCuller::isVisible(glm::vec3 center, glm::vec3 extents, float radius) const
+{
+	for (const glm::vec4& plane : planes)
+	{
+		float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+		float reach = min(glm::dot(glm::abs(glm::vec3(plane)), extents), radius);
+		if (distance < -reach)
+			return false;
+	}
+
+	return true;
+}
+
+size_t FrustumCuller::cull(const BoundsArray& bounds, vector<unsigned char>& visible) const
+{
+	size_t nbObjects = bounds.size();
+	visible.resize(nbObjects);
+
+	size_t nbVisible = 0;
+	size_t i = 0;
+
+#ifdef FRUSTUM_SSE
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= nbObjects; i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+		__m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+		__m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+		__m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+		__m128 radius = _mm_loadu_ps(&bounds.radius[i]);
+
+		// Bit k ligado = objeto i + k fora de algum plano
+		int outside = 0;
+
+		for (const glm::vec4& plane : planes)
+		{
+			__m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, centerX), _mm_mul_ps(ny, centerY)),
+				_mm_add_ps(_mm_mul_ps(nz, centerZ), _mm_set1_ps(plane.w)));
+
+			__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), extentX),
+				_mm_mul_ps(_mm_andnot_ps(signMask, ny), extentY)), _mm_mul_ps(_mm_andnot_ps(signMask, nz), extentZ));
+			reach = _mm_min_ps(reach, radius);
+
+			// distance + reach < 0
+			outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+		}
+
+		for (int k = 0; k < 4; k++)
+		{
+			visible[i + k] = (outside >> k & 1) == 0;
+			nbVisible += visible[i + k];
+		}
+	}
+#endif
+
+	// Resto (ou tudo, sem SSE)
+	for (; i < nbObjects; i++)
+	{
+		visible[i] = isVisible(glm::vec3(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]),
+			glm::vec3(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]), bounds.radius[i]);
+		nbVisible += visible[i];
+	}
+
+	return nbVisible;
+}
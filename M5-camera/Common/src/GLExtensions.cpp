@@ -0,0 +1,72 @@
+#include "GLExtensions.h"
+
+#include <cstring>
+
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+
+int GLAD_GL_ARB_buffer_storage = 0;
+int GLAD_GL_ARB_get_program_binary = 0;
+int GLAD_GL_KHR_parallel_shader_compile = 0;
+int GLAD_GL_ARB_multi_draw_indirect = 0;
+
+int getGLVersion()
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	return major * 10 + minor;
+}
+
+bool hasGLExtension(const char* name)
+{
+	GLint nbExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+
+	for (GLint i = 0; i < nbExtensions; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension && strcmp(extension, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool loadGLExtensions(GLADloadproc load)
+{
+	int version = getGLVersion();
+
+	if (version >= 44 || hasGLExtension("GL_ARB_buffer_storage"))
+		glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+	GLAD_GL_ARB_buffer_storage = glad_glBufferStorage != nullptr;
+
+	if (version >= 41 || hasGLExtension("GL_ARB_get_program_binary"))
+	{
+		glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+		glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+		glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+	}
+	GLint nbBinaryFormats = 0;
+	if (glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nbBinaryFormats);
+	GLAD_GL_ARB_get_program_binary = nbBinaryFormats > 0;
+
+	// Mesma funcao e constantes nas duas extensoes, so muda o sufixo
+	if (hasGLExtension("GL_KHR_parallel_shader_compile"))
+		glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+	else if (hasGLExtension("GL_ARB_parallel_shader_compile"))
+		glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+	GLAD_GL_KHR_parallel_shader_compile = glad_glMaxShaderCompilerThreadsKHR != nullptr;
+
+	if (version >= 43 || (hasGLExtension("GL_ARB_multi_draw_indirect") && hasGLExtension("GL_ARB_base_instance")))
+		glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+	GLAD_GL_ARB_multi_draw_indirect = glad_glMultiDrawElementsIndirect != nullptr;
+
+	return GLAD_GL_ARB_buffer_storage || GLAD_GL_ARB_get_program_binary || GLAD_GL_KHR_parallel_shader_compile ||
+		GLAD_GL_ARB_multi_draw_indirect;
+}
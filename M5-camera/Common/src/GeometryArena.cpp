@@ -0,0 +1,110 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+
+GeometryArena::GeometryArena(GLsizei vertexSize, size_t vertexCapacity, size_t indexCapacity)
+	: vertexSize(vertexSize), vertexCapacity(vertexCapacity), indexCapacity(indexCapacity)
+{
+	glGenVertexArrays(1, &VAO);
+
+	// Os uploads usam GL_COPY_WRITE_BUFFER: ligar o EBO fora do VAO mudaria o VAO atual
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * vertexSize, nullptr, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	setupVAO();
+}
+
+GeometryArena::~GeometryArena()
+{
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+}
+
+void GeometryArena::addAttribute(GLuint location, GLint size, size_t offset)
+{
+	attributes.push_back({ location, size, offset });
+	setupVAO();
+}
+
+ArenaMesh GeometryArena::add(const void* vertices, size_t nVertices, const GLuint* indices, size_t nIndices)
+{
+	bool grown = false;
+	if (nbVertices + nVertices > vertexCapacity)
+	{
+		size_t capacity = max(vertexCapacity * 2, nbVertices + nVertices);
+		grow(VBO, nbVertices * vertexSize, capacity * vertexSize);
+		vertexCapacity = capacity;
+		grown = true;
+	}
+	if (nbIndices + nIndices > indexCapacity)
+	{
+		size_t capacity = max(indexCapacity * 2, nbIndices + nIndices);
+		grow(EBO, nbIndices * sizeof(GLuint), capacity * sizeof(GLuint));
+		indexCapacity = capacity;
+		grown = true;
+	}
+	if (grown)
+		setupVAO();
+
+	ArenaMesh mesh;
+	mesh.firstIndex = (GLuint)nbIndices;
+	mesh.nIndices = (GLuint)nIndices;
+
+	// Indices da malha -> indices da arena
+	vector<GLuint> arenaIndices(indices, indices + nIndices);
+	for (GLuint& index : arenaIndices)
+		index += (GLuint)nbVertices;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, nbVertices * vertexSize, nVertices * vertexSize, vertices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, nbIndices * sizeof(GLuint), nIndices * sizeof(GLuint), arenaIndices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	nbVertices += nVertices;
+	nbIndices += nIndices;
+
+	return mesh;
+}
+
+void GeometryArena::grow(GLuint& buffer, GLsizeiptr usedSize, GLsizeiptr newSize)
+{
+	GLuint newBuffer;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+	if (usedSize > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &buffer);
+	buffer = newBuffer;
+}
+
+void GeometryArena::setupVAO()
+{
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	for (const Attribute& attribute : attributes)
+	{
+		glVertexAttribPointer(attribute.location, attribute.size, GL_FLOAT, GL_FALSE, vertexSize, (GLvoid*)attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(0);
+}
@@ -0,0 +1,58 @@
+#include "IndirectBatch.h"
+
+#include <cstring>
+
+#include "InstancedMesh.h"
+
+void IndirectBatch::initialize(GLuint VAO)
+{
+	this->VAO = VAO;
+}
+
+void IndirectBatch::clear()
+{
+	commands.clear();
+	models.clear();
+}
+
+void IndirectBatch::add(const ArenaMesh& mesh, const glm::mat4& model)
+{
+	// Uma instancia, e a matriz dela e a de indice baseInstance
+	DrawElementsIndirectCommand command;
+	command.count = mesh.nIndices;
+	command.instanceCount = 1;
+	command.firstIndex = mesh.firstIndex;
+	command.baseVertex = 0;
+	command.baseInstance = (GLuint)models.size();
+
+	commands.push_back(command);
+	models.push_back(model);
+}
+
+void IndirectBatch::draw(RingBuffer& ring)
+{
+	if (commands.empty())
+		return;
+
+	GLintptr modelOffset = 0, commandOffset = 0;
+	void* modelData = ring.allocate(models.size() * sizeof(glm::mat4), sizeof(glm::vec4), modelOffset);
+	void* commandData = ring.allocate(commands.size() * sizeof(DrawElementsIndirectCommand), sizeof(GLuint), commandOffset);
+	if (!modelData || !commandData)
+		return;
+	memcpy(modelData, models.data(), models.size() * sizeof(glm::mat4));
+	memcpy(commandData, commands.data(), commands.size() * sizeof(DrawElementsIndirectCommand));
+	ring.flush();
+
+	glBindVertexArray(VAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, ring.getBuffer());
+	InstancedMesh::setupModelAttributes(modelOffset);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// O mesmo buffer tambem serve de GL_DRAW_INDIRECT_BUFFER
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.getBuffer());
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)commandOffset, (GLsizei)commands.size(), 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glBindVertexArray(0);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "GLExtensions.h"
+#include "GeometryArena.h"
+#include "RingBuffer.h"
+
+using namespace std;
+
+// Parametros de uma chamada de desenho do glMultiDrawElementsIndirect, no layout da GL
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+// Objetos de qualquer malha da arena numa unica glMultiDrawElementsIndirect: um comando
+// por objeto, com a faixa de indices da malha. Comandos e matrizes vao no RingBuffer do
+// frame. A matriz model de cada comando vem do
+// mesmo atributo por instancia do InstancedMesh (locations 4 a 7), escolhida pelo
+// baseInstance; o gl_DrawID precisaria de GLSL 4.60 ou GL_ARB_shader_draw_parameters.
+// So pode ser usado com GLAD_GL_ARB_multi_draw_indirect.
+class IndirectBatch
+{
+public:
+	// VAO = o da arena. Para desenhar, o shader em uso precisa ter sido compilado com
+	// "#define INSTANCED"
+	void initialize(GLuint VAO);
+
+	// Comandos do proximo draw()
+	void clear();
+	void add(const ArenaMesh& mesh, const glm::mat4& model);
+	int getNbDraws() const { return (int)commands.size(); }
+
+	// Escreve as matrizes e os comandos no anel (depois do beginFrame do frame) e desenha
+	// tudo numa chamada
+	void draw(RingBuffer& ring);
+
+protected:
+	GLuint VAO = 0;
+
+	vector<DrawElementsIndirectCommand> commands;
+	vector<glm::mat4> models;
+};
@@ -0,0 +1,42 @@
+#include "InstancedMesh.h"
+
+#include <cstring>
+
+void InstancedMesh::initialize(GLuint VAO, const ArenaMesh& mesh)
+{
+	this->VAO = VAO;
+	this->mesh = mesh;
+}
+
+void InstancedMesh::setupModelAttributes(GLintptr offset)
+{
+	// Um mat4 ocupa 4 locations, uma por coluna; o divisor 1 avanca uma matriz por instancia
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glVertexAttribPointer(MODEL_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid*)(offset + i * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(MODEL_LOCATION + i);
+		glVertexAttribDivisor(MODEL_LOCATION + i, 1);
+	}
+}
+
+void InstancedMesh::draw(RingBuffer& ring)
+{
+	if (models.empty())
+		return;
+
+	// A regiao do frame so e reusada quando a GPU terminar de ler: sem orphaning nem copia do driver
+	GLintptr offset = 0;
+	void* data = ring.allocate(models.size() * sizeof(glm::mat4), sizeof(glm::vec4), offset);
+	if (!data)
+		return;
+	memcpy(data, models.data(), models.size() * sizeof(glm::mat4));
+	ring.flush();
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, ring.getBuffer());
+	setupModelAttributes(offset);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawElementsInstanced(GL_TRIANGLES, mesh.nIndices, GL_UNSIGNED_INT, (GLvoid*)(mesh.firstIndex * sizeof(GLuint)), (GLsizei)models.size());
+	glBindVertexArray(0);
+}
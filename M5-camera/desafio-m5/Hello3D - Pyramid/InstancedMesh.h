@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "GeometryArena.h"
+#include "RingBuffer.h"
+
+using namespace std;
+
+// Varias copias da mesma geometria numa unica chamada de desenho (glDrawElementsInstanced).
+// A matriz model de cada instancia vai no RingBuffer do frame, lida como atributo com
+// divisor 1 (locations 4 a 7, uma coluna por location), em vez de um glUniformMatrix4fv
+// por objeto.
+class InstancedMesh
+{
+public:
+	// Primeira location da matriz de instancia (ocupa 4 a 7)
+	static const GLuint MODEL_LOCATION = 4;
+
+	// Instancias da malha da arena (VAO = o da arena). Para desenhar, o shader em uso
+	// precisa ter sido compilado com "#define INSTANCED"
+	void initialize(GLuint VAO, const ArenaMesh& mesh);
+
+	// Instancias do proximo draw()
+	void clear() { models.clear(); }
+	void add(const glm::mat4& model) { models.push_back(model); }
+	int getNbInstances() const { return (int)models.size(); }
+
+	// Escreve as matrizes no anel (depois do beginFrame do frame) e desenha todas as instancias
+	void draw(RingBuffer& ring);
+
+	// Aponta as locations 4 a 7 do VAO ligado para as matrizes a partir de offset no
+	// GL_ARRAY_BUFFER ligado. O VAO e de todas as malhas da arena (shaders que nao leem
+	// essas locations nao sao afetados), entao cada desenho faz isso antes
+	static void setupModelAttributes(GLintptr offset);
+
+protected:
+	GLuint VAO = 0;
+	ArenaMesh mesh;
+	vector<glm::mat4> models;
+};
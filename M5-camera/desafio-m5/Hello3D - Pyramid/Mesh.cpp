@@ -1,28 +1,56 @@
 #include "Mesh.h"
 
-void Mesh::initialize(GLuint VAO, int nVertices, Shader* shader, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis)
+void Mesh::initialize(GLuint VAO, const ArenaMesh& geometry, Shader* shader, glm::vec3 position, glm::vec3 scale, float angle, glm::vec3 axis)
 {
 	this->VAO = VAO;
-	this->nVertices = nVertices;
+	this->geometry = geometry;
 	this->shader = shader;
+	this->modelUniform = shader->getUniform("model");
 	this->position = position;
 	this->scale = scale;
 	this->angle = angle;
 	this->axis = axis;
 }
 
+void Mesh::setBounds(glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	localCenter = (boundsMin + boundsMax) * 0.5f;
+	localExtents = (boundsMax - boundsMin) * 0.5f;
+}
+
 void Mesh::update()
 {
-	glm::mat4 model = glm::mat4(1);
+	model = glm::mat4(1);
 	model = glm::translate(model, position);
 	model = glm::rotate(model, glm::radians(angle), axis);
 	model = glm::scale(model, scale);
-	shader->setMat4("model", glm::value_ptr(model));
+
+	// AABB transformada (Arvo): cada eixo do mundo soma as projecoes dos eixos da caixa
+	glm::mat3 linear = glm::mat3(model);
+	worldCenter = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+	worldExtents = glm::vec3(0.0f);
+	for (int i = 0; i < 3; i++)
+		worldExtents += glm::abs(linear[i]) * localExtents[i];
+
+	// Esfera: a escala maior cobre os outros eixos
+	float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+	worldRadius = glm::length(localExtents) * maxScale;
+}
+
+void Mesh::submit(RenderQueue& queue, GLuint texture, float depth) const
+{
+	DrawCommand command;
+	command.program = shader->ID;
+	command.VAO = VAO;
+	command.textures[0] = texture;
+	command.first = geometry.firstIndex;
+	command.count = geometry.nIndices;
+	command.data = this;
+	command.key = RenderQueue::makeKey(0, shader->ID, texture, VAO, depth);
+	queue.submit(command);
 }
 
-void Mesh::draw()
+void Mesh::setupDraw() const
 {
-	glBindVertexArray(VAO);
-	glDrawArrays(GL_TRIANGLES, 0, nVertices);
-	glBindVertexArray(0);
+	shader->setMat4(modelUniform, glm::value_ptr(model));
 }
@@ -6,6 +6,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Shader.h"
+#include "RenderQueue.h"
+#include "GeometryArena.h"
 
 
 class Mesh
@@ -13,22 +15,47 @@ class Mesh
 public:
 	Mesh() {}
 	~Mesh() {}
-	void initialize(GLuint VAO, int nVertices, Shader* shader, glm::vec3 position = glm::vec3(0.0, 0.0, 0.0), glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
+	void initialize(GLuint VAO, const ArenaMesh& geometry, Shader* shader, glm::vec3 position = glm::vec3(0.0, 0.0, 0.0), glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0), float angle = 0.0, glm::vec3 axis = glm::vec3(0.0, 0.0, 1.0));
+	// AABB dos vertices no espaco do objeto (calculada no loadObj)
+	void setBounds(glm::vec3 boundsMin, glm::vec3 boundsMax);
+	// Monta a matriz model e leva a AABB e a esfera para o mundo
 	void update();
-	void draw();
+	// Poe a chamada de desenho na fila, com o objeto em data. depth em [0, 1] (0 = perto)
+	void submit(RenderQueue& queue, GLuint texture, float depth) const;
+	// Uniforms do objeto, chamado pela fila depois dos binds do comando
+	void setupDraw() const;
+
+	// Volumes envolventes no mundo, do ultimo update()
+	glm::vec3 getCenter() const { return worldCenter; }
+	glm::vec3 getExtents() const { return worldExtents; }
+	float getRadius() const { return worldRadius; }
+	// Matriz model do ultimo update() (para desenhar com instancias)
+	const glm::mat4& getModel() const { return model; }
+	// Faixa de indices da malha na arena
+	const ArenaMesh& getGeometry() const { return geometry; }
 
 protected:
 	GLuint VAO; //Identificador do Vertex Array Object - Vrtices e seus atributos
-	int nVertices;
+	ArenaMesh geometry; //Faixa de indices da malha no EBO vinculado ao VAO (o da arena)
 
 	//Informaes sobre as transformaes a serem aplicadas no objeto
 	glm::vec3 position;
 	glm::vec3 scale;
 	float angle;
 	glm::vec3 axis;
+	glm::mat4 model;
+
+	//Volumes envolventes: AABB (centro e metade do tamanho) e esfera com o mesmo centro
+	glm::vec3 localCenter = glm::vec3(0.0);
+	glm::vec3 localExtents = glm::vec3(0.0);
+	glm::vec3 worldCenter = glm::vec3(0.0);
+	glm::vec3 worldExtents = glm::vec3(0.0);
+	float worldRadius = 0.0f;
 
 	//Referncia (endereo) do shader
 	Shader* shader;
+	//Uniform "model" do shader, procurado uma vez no initialize
+	UniformHandle modelUniform = -1;
 
 };
 
@@ -2,6 +2,7 @@
 #include <string>
 #include <assert.h>
 #include <vector>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 
@@ -13,7 +14,13 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "Shader.h"
+#include "MeshOptimizer.h"
+#include "FrustumCuller.h"
+#include "FrameUniforms.h"
 #include "Mesh.h"
+#include "InstancedMesh.h"
+#include "IndirectBatch.h"
+#include "GeometryArena.h"
 #include "stb_image.h"
 
 struct Material {
@@ -24,17 +31,36 @@ struct Material {
 	float q;
 };
 
+// Malha carregada na arena e a sua AABB
+struct ObjModel {
+	ArenaMesh geometry;
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+};
+
 // Prot�tipo da fun��o de callback de teclado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 // Prot�tipo da fun��o de callback do mouse
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 
 int loadTexture(string path);
-int loadObj(string filepath, int &nVerts, glm::vec3 color = glm::vec3(1.0,0.0,1.0));
+ObjModel loadObj(string filepath, GeometryArena& arena, glm::vec3 color = glm::vec3(1.0,0.0,1.0));
 Material loadMaterial(string filename);
+void spawnMeshes(vector<Mesh>& meshes, int count, GLuint VAO, const vector<ObjModel>& models, Shader* shader);
+GLsizeiptr getDynamicSize(int count);
 
 bool rotateX = false, rotateY = false, rotateZ = false;
 
+// Teste de carga: N troca a quantidade de objetos, I troca o modo de desenho: uma chamada
+// por objeto, uma com instancias por malha ou uma glMultiDrawElementsIndirect para todos
+const int STRESS_COUNTS[] = { 1, 10000, 100000 };
+int stressLevel = 0;
+bool stressChanged = false;
+
+enum DrawMode { DRAW_PER_OBJECT, DRAW_INSTANCED, DRAW_INDIRECT, DRAW_MODES };
+const char* DRAW_MODE_NAMES[] = { "per-object", "instanced", "indirect" };
+int drawMode = DRAW_PER_OBJECT;
+
 glm::vec3 cameraPos = glm::vec3(0.0, 0.0, 3.0);
 glm::vec3 cameraFront = glm::vec3(0.0, 0.0, -1.0);
 glm::vec3 cameraUp = glm::vec3(0.0, 1.0, 0.0);
@@ -66,6 +92,7 @@ int main()
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
 	}
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 	// Obtendo as informações de versão
 	const GLubyte* renderer = glGetString(GL_RENDERER); /* get renderer string */
@@ -81,16 +108,24 @@ int main()
 	// Compilando e buildando o programa de shader
 	//GLuint shader.ID = setupShader();
 	Shader shader("Phong.vs","Phong.fs");
+	// O mesmo shader com a matriz model por instancia
+	Shader instancedShader("Phong.vs", "Phong.fs", true, "#define INSTANCED\n");
 
 	glUseProgram(shader.ID);
 
+	// Camera e luz ficam no bloco FrameData, enviado uma vez por frame
+	// Matrizes e comandos indiretos dos objetos vao no mesmo anel, depois do FrameData
+	FrameUniforms* frameUniforms = new FrameUniforms(getDynamicSize(STRESS_COUNTS[stressLevel]));
+	shader.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+	instancedShader.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+
 	//Matriz de view -- posição e orientação da câmera
 	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
-	shader.setMat4("view",value_ptr(view));
+	frameUniforms->data.view = view;
 
 	//Matriz de projeção perspectiva - definindo o volume de visualização (frustum)
 	glm::mat4 projection = glm::perspective(glm::radians(80.0f), (float)width / (float)height, 0.1f, 100.0f);
-	shader.setMat4("projection", glm::value_ptr(projection));
+	frameUniforms->data.projection = projection;
 
 	glEnable(GL_DEPTH_TEST);
 
@@ -100,23 +135,65 @@ int main()
 	//Carregando uma textura e armazenando o identificador na memória
 	GLuint texID = loadTexture("SuzanneTriTextured.mtl");
 
+	// Todas as malhas ficam nos buffers da arena, com um VAO so. Vertice: 3 pos + 3 cor +
+	// 2 texcoord + 3 normal
+	GeometryArena* arena = new GeometryArena(11 * sizeof(GLfloat));
+	//Atributo posicao (x, y, z)
+	arena->addAttribute(0, 3, 0);
+	//Atributo cor (r, g, b)
+	arena->addAttribute(1, 3, 3 * sizeof(GLfloat));
+	//Atributo coordenada de textura (s, t)
+	arena->addAttribute(2, 2, 6 * sizeof(GLfloat));
+	//Atributo normal do vertice (x, y, z)
+	arena->addAttribute(3, 3, 8 * sizeof(GLfloat));
+	GLuint VAO = arena->getVAO();
+
 	//Carregando OBJ
-	int nVerts;
-	GLuint VAO = loadObj("../../3D_models/Suzanne/suzanneTriLowPoly.obj", nVerts);
+	vector<ObjModel> models;
+	models.push_back(loadObj("../../3D_models/Suzanne/suzanneTriLowPoly.obj", *arena));
+	models.push_back(loadObj("../../3D_models/Cube/cube.obj", *arena));
+
+	vector<Mesh> meshes;
+	spawnMeshes(meshes, STRESS_COUNTS[stressLevel], VAO, models, &shader);
+
+	// Com instancias, uma chamada por malha
+	vector<InstancedMesh> instances(models.size());
+	for (size_t i = 0; i < models.size(); i++)
+		instances[i].initialize(VAO, models[i].geometry);
 
-	Mesh suzanne;
-	suzanne.initialize(VAO, nVerts, &shader);
+	// Indireto: uma chamada com um comando por objeto
+	IndirectBatch indirect;
+	if (GLAD_GL_ARB_multi_draw_indirect)
+		indirect.initialize(VAO);
+
+	// Sem instancias, uma chamada por objeto, ordenadas por estado e de frente para tras
+	RenderQueue renderQueue;
+
+	// Chamadas de desenho, instancias e trocas de estado, mostradas a cada segundo
+	double statsStart = glfwGetTime();
+	int statsFrames = 0;
+	long long statsDraws = 0, statsInstances = 0, statsStateChanges = 0;
+
+	//Objetos fora do frustum nao sao desenhados
+	FrustumCuller culler;
+	BoundsArray bounds;
+	vector<unsigned char> visible;
+	size_t lastVisible = SIZE_MAX;
 
 	// Definir as propriedades do material da superfície
-	shader.setVec3("ka", material.ka.r, material.ka.g, material.ka.b);
-	shader.setVec3("kd", material.kd.r, material.kd.g, material.kd.b);
-	shader.setVec3("ks", material.ks.r, material.ks.g, material.ks.b);
-	shader.setFloat("q", material.q);
+	for (Shader* program : { &shader, &instancedShader })
+	{
+		program->Use();
+		program->setVec3("ka", material.ka.r, material.ka.g, material.ka.b);
+		program->setVec3("kd", material.kd.r, material.kd.g, material.kd.b);
+		program->setVec3("ks", material.ks.r, material.ks.g, material.ks.b);
+		program->setFloat("q", material.q);
+	}
 
 	//Definindo a fonte de luz pontual
   // Definindo as propriedades da fonte de luz
-	shader.setVec3("lightPosition", 15.0f, 15.0f, 2.0f);
-	shader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+	frameUniforms->data.lightPos = glm::vec4(15.0f, 15.0f, 2.0f, 1.0f);
+	frameUniforms->data.lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
@@ -132,25 +209,112 @@ int main()
 		glLineWidth(10);
 		glPointSize(20);
 
+		// Antes do upload: aumentar o anel espera a GPU e troca o buffer
+		if (stressChanged)
+		{
+			spawnMeshes(meshes, STRESS_COUNTS[stressLevel], VAO, models, &shader);
+			RingBuffer& ring = frameUniforms->getRing();
+			ring.reserve(sizeof(FrameData) + ring.getUniformAlignment() + getDynamicSize(STRESS_COUNTS[stressLevel]));
+			stressChanged = false;
+		}
+
 		//Atualizando a posi��o e orienta��o da c�mera
 		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-		shader.setMat4("view", glm::value_ptr(view));
+		frameUniforms->data.view = view;
 
 		//Atualizando o shader com a posi��o da c�mera
-		shader.setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
+		frameUniforms->data.cameraPos = glm::vec4(cameraPos, 1.0f);
+		frameUniforms->upload();
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, texID);
 
+		// Volumes envolventes no mundo e teste do frustum, 4 objetos por vez
+		bounds.clear();
+		for (Mesh& mesh : meshes)
+		{
+			mesh.update();
+			bounds.add(mesh.getCenter(), mesh.getExtents(), mesh.getRadius());
+		}
+
+		culler.setup(projection * view);
+		size_t nbVisible = culler.cull(bounds, visible);
+		if (nbVisible != lastVisible)
+		{
+			cout << "Visible objects: " << nbVisible << "/" << meshes.size() << endl;
+			lastVisible = nbVisible;
+		}
+
 		// Chamada de desenho - drawcall
-		shader.setFloat("q", 10.0);
-		suzanne.update();
-		suzanne.draw();
+		Shader& program = drawMode == DRAW_PER_OBJECT ? shader : instancedShader;
+		program.Use();
+		program.setFloat("q", 10.0);
+		if (drawMode == DRAW_INSTANCED)
+		{
+			for (InstancedMesh& instanced : instances)
+				instanced.clear();
+			// spawnMeshes alterna as malhas: o objeto i e da malha i % models.size()
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				if (visible[i])
+					instances[i % instances.size()].add(meshes[i].getModel());
+			}
+			for (InstancedMesh& instanced : instances)
+			{
+				statsDraws += instanced.getNbInstances() > 0 ? 1 : 0;
+				instanced.draw(frameUniforms->getRing());
+			}
+		}
+		else if (drawMode == DRAW_INDIRECT)
+		{
+			indirect.clear();
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				if (visible[i])
+					indirect.add(meshes[i].getGeometry(), meshes[i].getModel());
+			}
+			indirect.draw(frameUniforms->getRing());
+			statsDraws += nbVisible > 0 ? 1 : 0;
+		}
+		else
+		{
+			// Distancia ate o far da projecao (100)
+			renderQueue.clear();
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				if (visible[i])
+					meshes[i].submit(renderQueue, texID, glm::length(meshes[i].getCenter() - cameraPos) / 100.0f);
+			}
+			renderQueue.sort();
+			renderQueue.execute([](const DrawCommand& command) { ((const Mesh*)command.data)->setupDraw(); });
+			glBindVertexArray(0);
+
+			statsDraws += nbVisible;
+			statsStateChanges += renderQueue.getStats().getStateChanges();
+		}
+		statsInstances += nbVisible;
+		statsFrames++;
+
+		double statsTime = glfwGetTime() - statsStart;
+		if (statsTime >= 1.0)
+		{
+			cout << DRAW_MODE_NAMES[drawMode] << ": " << meshes.size() << " objects, "
+				<< statsFrames / statsTime << " fps, " << statsDraws / statsTime << " draws/s, "
+				<< statsInstances / statsTime << " instances/s";
+			if (drawMode == DRAW_PER_OBJECT)
+				cout << ", " << (double)statsStateChanges / statsFrames << " state changes/frame";
+			cout << endl;
+			statsStart = glfwGetTime();
+			statsFrames = 0;
+			statsDraws = statsInstances = statsStateChanges = 0;
+		}
 		// Troca os buffers da tela
 		glfwSwapBuffers(window);
 	}
 	// Pede pra OpenGL desalocar os buffers
-	glDeleteVertexArrays(1, &VAO);
+	delete arena;
+	// Antes do glfwTerminate, enquanto o contexto ainda existe
+	delete frameUniforms;
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
@@ -185,6 +349,20 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		rotateZ = true;
 	}
 
+	if (key == GLFW_KEY_I && action == GLFW_PRESS)
+	{
+		// Sem GL_ARB_multi_draw_indirect o modo indireto e pulado
+		drawMode = (drawMode + 1) % DRAW_MODES;
+		if (drawMode == DRAW_INDIRECT && !GLAD_GL_ARB_multi_draw_indirect)
+			drawMode = DRAW_PER_OBJECT;
+	}
+
+	if (key == GLFW_KEY_N && action == GLFW_PRESS)
+	{
+		stressLevel = (stressLevel + 1) % (sizeof(STRESS_COUNTS) / sizeof(STRESS_COUNTS[0]));
+		stressChanged = true;
+	}
+
 	float cameraSpeed = 0.05;
 
 	if (key == GLFW_KEY_W)
@@ -235,6 +413,40 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 
 }
 
+// Bytes por frame no anel para count objetos: a matriz model e o comando indireto de cada
+// um (o modo instanciado so usa as matrizes), mais a folga do alinhamento das alocacoes
+GLsizeiptr getDynamicSize(int count)
+{
+	return count * (sizeof(glm::mat4) + sizeof(DrawElementsIndirectCommand)) + 4 * sizeof(glm::vec4);
+}
+
+// Um objeto fica na origem, como antes; mais que isso vira uma grade de count objetos
+// na frente da camera, cada um girado de um jeito. As malhas se alternam (a primeira e a
+// do objeto sozinho)
+void spawnMeshes(vector<Mesh>& meshes, int count, GLuint VAO, const vector<ObjModel>& models, Shader* shader)
+{
+	meshes.assign(count, Mesh());
+
+	int side = (int)ceil(cbrt((double)count));
+	float spacing = 2.5f;
+
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 position(0.0);
+		if (count > 1)
+		{
+			int x = i % side, y = (i / side) % side, z = i / (side * side);
+			position = glm::vec3((x - (side - 1) * 0.5f) * spacing, (y - (side - 1) * 0.5f) * spacing, -z * spacing);
+		}
+
+		const ObjModel& model = models[i % models.size()];
+		meshes[i].initialize(VAO, model.geometry, shader, position, glm::vec3(1.0), (float)(i * 37 % 360), glm::vec3(0.0, 1.0, 0.0));
+		meshes[i].setBounds(model.boundsMin, model.boundsMax);
+	}
+
+	cout << "Objects: " << count << endl;
+}
+
 Material loadMaterial(string filename) {
 	Material material;
 	ifstream file(filename);
@@ -337,13 +549,14 @@ int loadTexture(string mtlFilePath)
 	return texID;
 }
 
-int loadObj(string filepath, int& nVerts, glm::vec3 color)
+ObjModel loadObj(string filepath, GeometryArena& arena, glm::vec3 color)
 {
 	vector <glm::vec3> vertices;
 	vector <GLuint> indices;
 	vector <glm::vec2> texCoords;
 	vector <glm::vec3> normals;
 	vector <GLfloat> vbuffer;
+	unordered_map <uint64_t, GLuint> uniqueVertices;
 
 	ifstream inputFile;
 	inputFile.open(filepath.c_str());
@@ -394,29 +607,42 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 					//Recuperando os indices de v
 					int pos = tokens[i].find("/");
 					string token = tokens[i].substr(0, pos);
-					int index = atoi(token.c_str()) - 1;
-					indices.push_back(index);
-
-					vbuffer.push_back(vertices[index].x);
-					vbuffer.push_back(vertices[index].y);
-					vbuffer.push_back(vertices[index].z);
-					vbuffer.push_back(color.r);
-					vbuffer.push_back(color.g);
-					vbuffer.push_back(color.b);
+					int vIndex = atoi(token.c_str()) - 1;
 
 					//Recuperando os indices de vts
 					tokens[i] = tokens[i].substr(pos + 1);
 					pos = tokens[i].find("/");
 					token = tokens[i].substr(0, pos);
-					index = atoi(token.c_str()) - 1;
-					vbuffer.push_back(texCoords[index].s);
-					vbuffer.push_back(texCoords[index].t);
+					int tIndex = atoi(token.c_str()) - 1;
+
 					//Recuperando os indices de vns
 					tokens[i] = tokens[i].substr(pos + 1);
-					index = atoi(tokens[i].c_str()) - 1;
-					vbuffer.push_back(normals[index].x);
-					vbuffer.push_back(normals[index].y);
-					vbuffer.push_back(normals[index].z);
+					int nIndex = atoi(tokens[i].c_str()) - 1;
+
+					//Se a tripla v/vt/vn ja apareceu, reaproveita o vertice pelo indice
+					uint64_t key = ((uint64_t)vIndex << 42) | ((uint64_t)tIndex << 21) | (uint64_t)nIndex;
+					auto found = uniqueVertices.find(key);
+					if (found != uniqueVertices.end())
+					{
+						indices.push_back(found->second);
+						continue;
+					}
+
+					GLuint index = vbuffer.size() / 11;
+					uniqueVertices[key] = index;
+					indices.push_back(index);
+
+					vbuffer.push_back(vertices[vIndex].x);
+					vbuffer.push_back(vertices[vIndex].y);
+					vbuffer.push_back(vertices[vIndex].z);
+					vbuffer.push_back(color.r);
+					vbuffer.push_back(color.g);
+					vbuffer.push_back(color.b);
+					vbuffer.push_back(texCoords[tIndex].s);
+					vbuffer.push_back(texCoords[tIndex].t);
+					vbuffer.push_back(normals[nIndex].x);
+					vbuffer.push_back(normals[nIndex].y);
+					vbuffer.push_back(normals[nIndex].z);
 				}
 			}
 		}
@@ -426,45 +652,29 @@ int loadObj(string filepath, int& nVerts, glm::vec3 color)
 		cout << "Problema ao encontrar o arquivo " << filepath << endl;
 	}
 	inputFile.close();
-	GLuint VBO, VAO;
-	nVerts = vbuffer.size() / 11; // 3 pos + 3 cor + 3 normal + 2 texcoord
-	//Gera��o do identificador do VBO
-	glGenBuffers(1, &VBO);
-	//Faz a conex�o (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	//Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, vbuffer.size() * sizeof(GLfloat), vbuffer.data(), GL_STATIC_DRAW);
-	//Gera��o do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de v�rtices
-	// e os ponteiros para os atributos 
-	glBindVertexArray(VAO);
-	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando: 
-	// Localiza��o no shader * (a localiza��o dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	// Numero de valores que o atributo tem (por ex, 3 coordenadas xyz) 
-	// Tipo do dado
-	// Se est� normalizado (entre zero e um)
-	// Tamanho em bytes 
-	// Deslocamento a partir do byte zero 
-	//Atributo posi��o (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-	//Atributo cor (r, g, b)
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-	//Atributo coordenada de textura (s, t)
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	//Atributo normal do v�rtice (x, y, z)
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-	// Observe que isso � permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de v�rtice 
-	// atualmente vinculado - para que depois possamos desvincular com seguran�a
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	// Desvincula o VAO (� uma boa pr�tica desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
-	return VAO;
+
+	//Reordena triangulos e vertices para o cache de vertices e o overdraw
+	MeshOptimizerStats stats;
+	size_t nbVertices = optimizeMesh(vbuffer.data(), vbuffer.size() / 11, 11 * sizeof(GLfloat), indices.data(), indices.size(), {},
+		vbuffer.data(), 11 * sizeof(GLfloat), stats);
+	vbuffer.resize(nbVertices * 11);
+
+	//AABB das posicoes, para o teste do frustum
+	ObjModel model;
+	model.boundsMin = glm::vec3(0.0);
+	model.boundsMax = glm::vec3(0.0);
+	for (size_t i = 0; i < nbVertices; i++)
+	{
+		glm::vec3 p(vbuffer[i * 11], vbuffer[i * 11 + 1], vbuffer[i * 11 + 2]);
+		model.boundsMin = i == 0 ? p : glm::min(model.boundsMin, p);
+		model.boundsMax = i == 0 ? p : glm::max(model.boundsMax, p);
+	}
+	cout << filepath << ": ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+		<< ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << endl;
+
+	// vbuffer: 3 pos + 3 cor + 2 texcoord + 3 normal por vertice unico
+	model.geometry = arena.add(vbuffer.data(), nbVertices, indices.data(), indices.size());
+	return model;
 }
 
 
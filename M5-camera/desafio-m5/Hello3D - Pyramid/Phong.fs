@@ -7,8 +7,16 @@ in vec2 textureCoord;
 in vec3 fragmentPosition;
 
 // Declara as variáveis uniformes do shader. 
-uniform vec3 lightColor;
-uniform vec3 lightPosition;
+// Camera e luz, compartilhadas por frame (FrameUniforms.h)
+layout(std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
 // Coeficientes de reflexão
 uniform vec3 ka;
 // Coeficientes de reflexão difusa
@@ -18,7 +26,6 @@ uniform vec3 ks;
 // Expoente de reflexão especular
 uniform float q;
 
-uniform vec3 cameraPos;
 uniform sampler2D tex_buffer;
 
 out vec4 color;
@@ -26,19 +33,19 @@ out vec4 color;
 void main()
 {
 	// Cálculo da parcela de iluminação ambiente
-	vec3 ambient = ka * lightColor;
+	vec3 ambient = ka * lightColor.rgb;
 	
 	// Cálculo da parcela de iluminação difusa
 	vec3 N = normalize(scaledNormal);
-	vec3 L = normalize(lightPosition - fragmentPosition);
+	vec3 L = normalize(lightPos.xyz - fragmentPosition);
 	float diff = max(dot(N,L),0.0);
-	vec3 diffuse = kd * diff * lightColor;
+	vec3 diffuse = kd * diff * lightColor.rgb;
 
-	vec3 V = normalize(cameraPos - fragmentPosition);
+	vec3 V = normalize(cameraPos.xyz - fragmentPosition);
 	vec3 R = normalize(reflect(-L,N));
 	float spec = max(dot(R,V),0.0);
 	spec = pow(spec, q);
-	vec3 specular = ks * spec * lightColor;
+	vec3 specular = ks * spec * lightColor.rgb;
 
 	vec3 texColor = texture(tex_buffer, textureCoord).xyz;
 	vec3 result = (ambient + diffuse) * texColor + specular;
@@ -7,9 +7,22 @@ layout (location = 2) in vec2 tex_coord;
 layout (location = 3) in vec3 normal;
 
 // Declara as variáveis uniformes do shader
+#ifdef INSTANCED
+// Com instancias, cada uma traz a sua matriz (InstancedMesh, locations 4 a 7)
+layout (location = 4) in mat4 model;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
+
+// Camera e luz, compartilhadas por frame (FrameUniforms.h)
+layout(std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
 
 // Declara as variáveis de saída (outputs) do shader
 out vec3 finalColor;
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+enum AssetState
+{
+	ASSET_QUEUED,    // esperando uma thread de trabalho
+	ASSET_LOADING,   // lendo/decodificando na thread de trabalho
+	ASSET_UPLOADING, // esperando (ou no meio do) envio para a GPU
+	ASSET_READY,
+	ASSET_FAILED
+};
+
+// Resultado de cada chamada da funcao de upload
+enum UploadResult
+{
+	UPLOAD_DONE, // o asset esta todo na GPU
+	UPLOAD_MORE, // enviou uma parte; chamar de novo
+	UPLOAD_WAIT  // nada para enviar agora (a thread de trabalho ainda esta produzindo)
+};
+
+// Carrega assets sem travar o loop principal. A parte pesada (leitura, parse,
+// decodificacao de imagens) roda em threads de trabalho, sem nenhuma chamada GL;
+// o envio para a GPU roda no render thread, dentro do update(), que a cada frame
+// so gasta o tempo de budgetMs. Cada upload deve enviar uma parte pequena por chamada.
+class AssetLoader
+{
+public:
+	typedef function<bool()> WorkFunction;
+	typedef function<UploadResult()> UploadFunction;
+
+	AssetLoader(int nbThreads = 2);
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Enfileira um asset e retorna o seu id. Se work retornar false o asset falha e
+	// upload nunca e chamado. Com uploadWhileLoading, upload ja e chamado enquanto
+	// work roda (produtor/consumidor, como no carregamento em streaming).
+	int load(const string& name, WorkFunction work, UploadFunction upload, bool uploadWhileLoading = false);
+
+	// Chamado pelo render thread uma vez por frame
+	void update(double budgetMs);
+
+	AssetState getState(int asset) const { return assets[asset]->state; }
+	bool isReady(int asset) const { return getState(asset) == ASSET_READY; }
+	// Nenhum asset na fila, carregando ou enviando
+	bool isIdle() const;
+	// Para work functions longas abandonarem o trabalho quando o programa fecha
+	bool isStopping() const { return stopping; }
+
+	// Tempos em ms desde o pedido do asset (-1 se ainda nao aconteceu)
+	double getWorkTime(int asset) const;
+	double getLoadTime(int asset) const;
+	void printStats() const;
+
+protected:
+	typedef chrono::steady_clock Clock;
+
+	struct Asset
+	{
+		string name;
+		WorkFunction work;
+		UploadFunction upload;
+		bool uploadWhileLoading;
+		atomic<AssetState> state;
+		Clock::time_point requestTime, workEndTime, readyTime;
+		double uploadTime = 0.0; // ms gastos dentro do upload
+	};
+
+	void workerLoop();
+
+	vector<unique_ptr<Asset>> assets;
+	vector<thread> workers;
+
+	mutex queueLock;
+	condition_variable queueChanged;
+	deque<Asset*> queue;
+	atomic<bool> stopping;
+};
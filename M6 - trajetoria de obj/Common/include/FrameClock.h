@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+
+using namespace std;
+
+// Passo fixo padrao da simulacao (60 atualizacoes por segundo)
+const double SIMULATION_STEP = 1.0 / 60.0;
+// Frames mais longos que isso (carga, janela arrastada...) contam so ate esse limite,
+// para a simulacao nao precisar de centenas de passos para alcancar o relogio
+const double MAX_FRAME_TIME = 0.25;
+
+// Relogio do loop principal: mede cada frame com um relogio monotono de alta resolucao
+// e converte o tempo em passos de tamanho fixo da simulacao. O que sobra (menos de um
+// passo) vira o alpha, a fracao entre o estado anterior e o atual usada para interpolar
+// o desenho. Assim a animacao anda na mesma velocidade com qualquer taxa de frames.
+//
+//	int steps = clock.tick();
+//	for (int i = 0; i < steps; i++)
+//		scene.update(clock.getStep());
+//	scene.drawFrame(clock.getAlpha());
+//	clock.limitFrame();
+class FrameClock
+{
+public:
+	FrameClock(double step = SIMULATION_STEP);
+
+	// Recomeca a medir a partir de agora, sem passos pendentes
+	void reset();
+
+	// Fecha o frame pelo relogio e devolve quantos passos a simulacao deve dar
+	int tick();
+	// O mesmo, com a duracao do frame dada em vez da medida (execucoes reproduziveis)
+	int advance(double frameTime);
+
+	// Limite de frames por segundo para o limitFrame() (0 = sem limite)
+	void setFrameLimit(double fps) { frameLimit = fps; }
+	double getFrameLimit() const { return frameLimit; }
+	// Espera ate o inicio do proximo frame, se houver limite. Chamar no fim do frame
+	void limitFrame();
+
+	double getStep() const { return step; }
+	// Fracao do passo (0 a 1) entre o estado anterior e o atual da simulacao
+	double getAlpha() const { return accumulator / step; }
+	// Tempo da simulacao no ultimo passo e no estado desenhado (interpolado)
+	double getTime() const { return simulationTime; }
+	double getInterpolatedTime() const { return simulationTime - step + accumulator; }
+	// Duracao do ultimo frame, em segundos
+	double getFrameTime() const { return frameTime; }
+	long long getNbFrames() const { return nbFrames; }
+	long long getNbSteps() const { return nbSteps; }
+
+	// Segundos no relogio monotono (origem arbitraria)
+	static double now();
+
+protected:
+	typedef chrono::steady_clock Clock;
+
+	double step;
+	double accumulator = 0.0;
+	double simulationTime = 0.0;
+	double frameTime = 0.0;
+	long long nbFrames = 0, nbSteps = 0;
+
+	Clock::time_point lastTick;
+	double frameLimit = 0.0;
+	Clock::time_point nextFrame;
+};
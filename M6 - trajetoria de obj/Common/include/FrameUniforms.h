@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "RingBuffer.h"
+
+// Ponto de ligacao do bloco FrameData em todos os programas
+const GLuint FRAME_DATA_BINDING = 0;
+
+// Estado da camera e da luz, igual ao bloco std140 dos shaders:
+//
+//   layout(std140) uniform FrameData
+//   {
+//       mat4 view;
+//       mat4 projection;
+//       vec4 cameraPos;  // xyz
+//       vec4 lightPos;   // xyz
+//       vec4 lightColor; // rgb
+//   };
+//
+// Os vec3 viram vec4: no std140 um vec3 ocupa 16 bytes de qualquer jeito.
+struct FrameData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 cameraPos;
+	glm::vec4 lightPos;
+	glm::vec4 lightColor;
+};
+
+// Bloco FrameData, enviado uma vez por frame e compartilhado por todos os programas
+// (Shader::bindUniformBlock). Cada upload() comeca um frame no RingBuffer (mapeado, com
+// fences, quando a GL permite) e escreve o bloco no inicio da regiao; o resto da regiao
+// fica para os outros dados dinamicos do frame (getRing()).
+class FrameUniforms
+{
+public:
+	// dynamicSize: bytes por frame para os outros dados, alem do FrameData. Precisa de um
+	// contexto atual e do loadGLExtensions ja chamado
+	FrameUniforms(GLsizeiptr dynamicSize = 0);
+
+	// Valores do proximo upload()
+	FrameData data;
+
+	// Copia data para a GPU e liga o bloco em FRAME_DATA_BINDING; chamar uma vez por
+	// frame, antes dos desenhos
+	void upload();
+
+	// Anel dos dados dinamicos: o que for alocado depois do upload() vale ate o proximo
+	RingBuffer& getRing() { return ring; }
+	bool isPersistent() const { return ring.isPersistent(); }
+
+protected:
+	RingBuffer ring;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// O GLAD do projeto foi gerado para a OpenGL 3.3 core, sem extensoes. As funcoes mais
+// novas usadas aqui sao carregadas a parte, no mesmo estilo (glad_gl* + #define), e so
+// podem ser chamadas quando a flag correspondente estiver ligada.
+
+// GL_ARB_buffer_storage (core na 4.4): buffers imutaveis e mapeamento persistente
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+
+// GL_ARB_get_program_binary (core na 4.1): programas ja linkados salvos e recarregados
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glad_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri;
+#define glGetProgramBinary glad_glGetProgramBinary
+#define glProgramBinary glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+
+// GL_KHR_parallel_shader_compile (ou a versao ARB): o driver compila em outras threads
+// e GL_COMPLETION_STATUS_KHR diz, sem esperar, se o shader ou o programa ja terminou
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+
+// GL_ARB_multi_draw_indirect (core na 4.3): varias chamadas de desenho lidas de um buffer,
+// com os parametros no formato de DrawElementsIndirectCommand
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+
+extern int GLAD_GL_ARB_buffer_storage;
+// Ligada so se o driver tambem aceitar algum formato binario (alguns anunciam 0)
+extern int GLAD_GL_ARB_get_program_binary;
+extern int GLAD_GL_KHR_parallel_shader_compile;
+// Ligada so com GL_ARB_base_instance tambem (core na 4.2): sem ele o baseInstance dos
+// comandos e ignorado
+extern int GLAD_GL_ARB_multi_draw_indirect;
+
+// Chamar depois do gladLoadGLLoader, com o mesmo load (glfwGetProcAddress,
+// eglGetProcAddress). Retorna false se nenhuma extensao estiver disponivel.
+bool loadGLExtensions(GLADloadproc load);
+
+// Versao do contexto atual (4.5 = 45)
+int getGLVersion();
+bool hasGLExtension(const char* name);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+using namespace std;
+
+// Frames de queries em uso: o resultado de um frame so e lido PROFILER_LATENCY frames
+// depois. O driver pode enfileirar ate 3 frames, entao 4 da folga para a GPU terminar
+const int PROFILER_LATENCY = 4;
+// Frames guardados para as estatisticas de cada escopo
+const size_t PROFILER_WINDOW = 300;
+
+// Tempo de GPU de um escopo nos ultimos frames da janela, em ms
+struct GpuScopeStats
+{
+	string name;
+	size_t nbSamples = 0;
+	double minMs = 0.0;
+	double avgMs = 0.0;
+	double p99Ms = 0.0;
+};
+
+// Mede o tempo de GPU de trechos com nome (clear, malhas opacas...) com um par de
+// GL_TIMESTAMP por escopo. Escopos podem ser aninhados e convivem com uma query
+// GL_TIME_ELAPSED em volta do frame. As queries de cada frame ficam num anel de
+// PROFILER_LATENCY frames; o beginFrame() le as do frame mais antigo e nunca espera a
+// GPU: se algum resultado ainda nao estiver disponivel, o frame e descartado (conta em
+// getNbSkippedFrames()). Um escopo que aparece mais de uma vez no frame conta a soma.
+class GpuProfiler
+{
+public:
+	GpuProfiler() {}
+	~GpuProfiler();
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// Desligado, os escopos nao emitem queries
+	void setEnabled(bool enabled) { this->enabled = enabled; }
+	bool isEnabled() const { return enabled; }
+
+	// Comeca um frame, lendo os resultados de PROFILER_LATENCY frames atras (sem esperar).
+	// Chamar antes do primeiro escopo do frame
+	void beginFrame();
+
+	void beginScope(const string& name);
+	void endScope();
+
+	// Le os frames que ainda estao no anel, esperando a GPU: para o fim de uma medicao
+	void finish();
+
+	// Escopos na ordem em que apareceram pela primeira vez
+	vector<GpuScopeStats> getStats() const;
+	// Descarta as amostras (as queries em voo continuam valendo)
+	void clearStats();
+	// Frames descartados porque a GPU ainda nao tinha os resultados quando foram lidos
+	size_t getNbSkippedFrames() const { return nbSkippedFrames; }
+
+	// Uma linha por escopo, com minimo, media e p99
+	void report(ostream& out) const;
+	// Acrescenta uma linha por escopo ao CSV (com cabecalho se o arquivo for novo)
+	bool appendCsv(const string& file, const string& run) const;
+
+protected:
+	struct ScopeQuery
+	{
+		int scope;
+		GLuint begin, end;
+		bool closed;
+	};
+
+	struct FrameQueries
+	{
+		vector<GLuint> pool;
+		size_t nbUsed = 0;
+		vector<ScopeQuery> scopes;
+	};
+
+	struct ScopeSamples
+	{
+		string name;
+		vector<double> samples; // anel de PROFILER_WINDOW frames
+		size_t next = 0;
+	};
+
+	bool enabled = true;
+	FrameQueries frames[PROFILER_LATENCY];
+	int frame = 0;
+	vector<int> open; // escopos abertos do frame atual (indices em scopes)
+
+	unordered_map<string, int> scopeIds;
+	vector<ScopeSamples> scopeSamples;
+	vector<double> frameTotals; // soma por escopo do frame lido
+	size_t nbSkippedFrames = 0;
+
+	GLuint nextQuery(FrameQueries& queries);
+	// Passa para o proximo frame do anel, lendo o que estava nele
+	void advance(bool wait);
+	// Com wait, espera a GPU; sem, descarta o frame se algum resultado nao estiver pronto
+	void collect(FrameQueries& queries, bool wait);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Um bloco newmtl de um .mtl. Cada linha "chave valor" vira properties[chave] = valor
+// (so o primeiro valor da linha, como "Kd 0.8 0.8 0.8" -> "0.8").
+struct Material
+{
+	string name;
+	map<string, string> properties;
+};
+
+// Tabela de materiais lida de um ou mais .mtl
+class MaterialLibrary
+{
+public:
+	MaterialLibrary() {}
+
+	// Acrescenta todos os materiais de filename. Os caminhos das texturas (map_*, bump, norm)
+	// que nao existirem como estao sao procurados na pasta do .mtl.
+	bool loadFile(const string& filename);
+	void clear() { materials.clear(); }
+
+	// Indice do material com esse nome (o ultimo lido, se houver repetidos), ou -1
+	int find(const string& name) const;
+	int getNbMaterials() const { return materials.size(); }
+	const Material& getMaterial(int material) const { return materials[material]; }
+
+protected:
+	vector<Material> materials;
+};
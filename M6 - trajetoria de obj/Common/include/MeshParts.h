@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Parte da malha desenhada com um unico material: indices [firstIndex, firstIndex + nbIndices)
+// (ou vertices, numa malha sem indices)
+struct Submesh
+{
+	uint32_t firstIndex;
+	uint32_t nbIndices;
+	int32_t object;   // indice em objectNames (-1 = antes de qualquer o/g)
+	int32_t material; // indice em materialNames (-1 = sem usemtl)
+};
+
+// Grupo de triangulos vizinhos (ate MESHLET_MAX_VERTICES vertices e MESHLET_MAX_TRIANGLES
+// triangulos) com os dados para descartar o grupo inteiro na CPU: esfera envolvente e
+// cone das normais, no espaco do objeto. Os triangulos sao os indices
+// [firstIndex, firstIndex + nbIndices) da malha, sempre dentro de uma submesh.
+struct Meshlet
+{
+	float center[3];
+	float radius;
+	float coneAxis[3];
+	float coneCutoff; // seno da abertura do cone (1 = nunca descartado pelo cone)
+	uint32_t firstIndex;
+	uint32_t nbIndices;
+};
+
+// Nivel de detalhe simplificado: as submeshes [firstSubmesh, firstSubmesh + nbSubmeshes)
+// de lodSubmeshes, uma para cada submesh do nivel 0 (mesmo objeto e material), com
+// indices proprios no fim do index buffer
+struct MeshLod
+{
+	uint32_t firstSubmesh;
+	uint32_t nbSubmeshes;
+	uint32_t nbTriangles;
+	float error; // distancia estimada ate a malha original, no espaco do objeto
+};
+
+// Partes de uma malha e os nomes que elas referenciam
+struct MeshParts
+{
+	vector<Submesh> submeshes;
+	vector<string> objectNames;
+	vector<string> materialNames;
+	vector<string> materialLibraries; // arquivos das linhas mtllib, como aparecem no .obj
+	vector<Meshlet> meshlets;         // em ordem de firstIndex (vazio na malha sem indices)
+	vector<MeshLod> lods;             // niveis 1, 2, ... (o nivel 0 e submeshes)
+	vector<Submesh> lodSubmeshes;
+
+	void clear()
+	{
+		submeshes.clear();
+		objectNames.clear();
+		materialNames.clear();
+		materialLibraries.clear();
+		meshlets.clear();
+		lods.clear();
+		lodSubmeshes.clear();
+	}
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "MeshParts.h"
+
+using namespace std;
+
+// Niveis de detalhe gerados alem do original; cada um tem LOD_REDUCTION dos triangulos
+// do anterior. Um nivel que nao tira pelo menos MIN_LOD_REDUCTION do anterior (malha
+// ja muito simples ou presa pelas bordas) ou que ficaria vazio encerra a cadeia.
+const int MAX_LODS = 4;
+const float LOD_REDUCTION = 0.5f;
+const float MIN_LOD_REDUCTION = 0.2f;
+
+// Simplifica uma lista de triangulos por colapso de arestas com a metrica de erro quadrica
+// (Garland e Heckbert 1997) ate targetIndices indices. Nenhum vertice e criado: cada
+// colapso leva um vertice ate um vizinho, e os vertices na mesma posicao (costuras de
+// textura e normal) andam juntos; cada canto fica com a variante do destino de atributos
+// mais parecidos. attributes: nbAttributes floats por vertice (pode ser nullptr).
+// Grava os indices em destination (cabem nbIndices) e retorna quantos sao; error recebe
+// a distancia estimada ate a superficie original, no espaco do objeto.
+size_t simplifyMesh(unsigned int* destination, const unsigned int* indices, size_t nbIndices, const float* positions, size_t positionStride,
+	const float* attributes, size_t nbAttributes, size_t nbVertices, size_t targetIndices, float& error);
+
+// Cadeia de LODs: simplifica submesh por submesh, cada nivel a partir do anterior, e
+// acrescenta os indices de cada nivel ao fim de indices. Preenche parts.lods e
+// parts.lodSubmeshes.
+void buildLods(vector<unsigned int>& indices, MeshParts& parts, const float* positions, size_t positionStride,
+	const float* attributes, size_t nbAttributes, size_t nbVertices);
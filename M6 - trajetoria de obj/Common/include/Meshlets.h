@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshOptimizer.h"
+#include "MeshParts.h"
+
+using namespace std;
+
+// Limites de um meshlet (os mesmos usados com mesh shaders)
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+// Divide cada faixa de indices em meshlets, sem mudar a ordem dos triangulos: depois do
+// optimizeMesh os triangulos vizinhos ja estao juntos. Um meshlet tambem termina quando
+// as normais se espalham demais. positions: xyz em float do vertice 0; positionStride
+// em bytes. Numa malha aberta o cone de normais fica desligado (coneCutoff = 1), ja que
+// o verso dos triangulos pode aparecer.
+void buildMeshlets(const unsigned int* indices, size_t nbIndices, const vector<IndexRange>& ranges, const float* positions,
+	size_t positionStride, size_t nbVertices, vector<Meshlet>& meshlets);
+
+// Malha fechada: toda aresta e usada nos dois sentidos (vertices soldados pela posicao,
+// ja que as costuras de textura e normal duplicam vertices)
+bool isClosedMesh(const unsigned int* indices, size_t nbIndices, const float* positions, size_t positionStride, size_t nbVertices);
+
+// Descarte de meshlets na CPU: frustum e camera levados para o espaco do objeto uma vez
+// por frame, para testar os meshlets sem transforma-los
+class ClusterCuller
+{
+public:
+	// projectionView * model; model com escala uniforme (o cone depende dos angulos)
+	void setup(const glm::mat4& projectionView, const glm::mat4& model, glm::vec3 cameraPosition);
+
+	bool isVisible(const Meshlet& meshlet) const;
+
+protected:
+	glm::vec4 planes[6]; // dentro: dot(xyz, p) + w >= 0
+	glm::vec3 camera;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "MeshParts.h"
+#include "VertexFormat.h"
+
+using namespace std;
+
+// Indices (base 0) de posicao, coordenada de textura e normal de um canto de face.
+// -1 indica que o atributo nao foi informado no arquivo.
+struct ObjIndex
+{
+	int v, t, n;
+};
+
+// Linha o/g (troca de objeto) ou usemtl (troca de material): vale a partir de firstTriangle
+// ate a proxima. O que a linha nao troca continua valendo o do grupo anterior.
+struct ObjGroup
+{
+	int firstTriangle;
+	bool setsObject;
+	bool setsMaterial;
+	string name;
+};
+
+// Dados brutos de um OBJ, do jeito que aparecem no arquivo (ainda indexados)
+struct ObjMesh
+{
+	vector<float> positions; // x, y, z
+	vector<float> texCoords; // s, t
+	vector<float> normals;   // nx, ny, nz
+	vector<ObjIndex> corners; // 3 cantos por triangulo (vazio no loadFileStreaming)
+	vector<ObjGroup> groups;
+	vector<string> materialLibraries;
+	int nbTriangles = 0;
+
+	int getNbPositions() const { return positions.size() / 3; }
+	int getNbTexCoords() const { return texCoords.size() / 2; }
+	int getNbNormals() const { return normals.size() / 3; }
+	int getNbTriangles() const { return nbTriangles; }
+	void computeBounds(MeshBounds& bounds) const;
+	void clear();
+};
+
+// Canto de face cujo indice era negativo (relativo ao fim da lista) e que, num
+// bloco lido em paralelo, ainda precisa ser deslocado pelos blocos anteriores.
+// attribute: 0 = v, 1 = vt, 2 = vn
+struct ObjFixup
+{
+	int corner;
+	int attribute;
+};
+
+// Leitor de OBJ que percorre o arquivo inteiro como um unico buffer de chars,
+// sem criar strings/streams por linha. Os numeros sao convertidos com from_chars.
+// Os vetores internos sao reaproveitados entre chamadas de loadFile.
+class ObjLoader
+{
+public:
+	ObjLoader() {}
+	bool loadFile(const string& filename);
+	// Igual a loadFile, mas divide o arquivo em blocos (em fim de linha) lidos
+	// por varias threads. nbThreads = 0 usa hardware_concurrency().
+	bool loadFileParallel(const string& filename, int nbThreads = 0);
+	void parse(const char* begin, const char* end);
+	void parseParallel(const char* begin, const char* end, int nbThreads = 0);
+	// Gera o buffer intercalado de 11 floats por vertice (pos, cor, st, normal)
+	void buildInterleaved(vector<float>& buffer) const;
+	// Cada tripla v/vt/vn distinta vira um unico vertice, gravado no layout de format,
+	// e os triangulos sao descritos por indices (para glDrawElements). Os triangulos sao
+	// agrupados por material, para que as partes com o mesmo material fiquem vizinhas.
+	// Depois sao gerados os niveis de detalhe (buildLods, no fim de indices) e cada parte
+	// de cada nivel e reordenada para o cache de vertices e o overdraw (optimizeMesh) e
+	// dividida em meshlets (parts.meshlets). stats recebe o ACMR/ATVR antes e depois
+	// da otimizacao. Sem cook, para nos vertices e indices do nivel 0 (o que o
+	// LoaderBenchmark compara com o loader antigo).
+	void buildIndexed(const VertexFormat& format, vector<unsigned char>& vertices, vector<unsigned int>& indices, MeshBounds& bounds,
+		MeshParts& parts, MeshOptimizerStats* stats = nullptr, bool cook = true) const;
+	// Partes na ordem do arquivo, em vertices de 3 por triangulo (malhas sem indices)
+	void buildParts(MeshParts& parts) const;
+	const ObjMesh& getMesh() const { return mesh; }
+
+	// Modo de memoria limitada, para arquivos muito grandes: o arquivo e lido em blocos
+	// de STREAM_BLOCK_SIZE e nem os cantos nem a tabela de vertices unicos sao montados.
+	// Os vertices (nao indexados, 3 por triangulo) sao gravados no layout de format num
+	// buffer de stagingSize bytes, entregue a upload (offset em bytes no VBO) sempre que
+	// enche. Sao duas passadas: a primeira so conta os triangulos e calcula a AABB, para
+	// que beginUpload possa alocar o VBO inteiro antes do primeiro bloco.
+	// So as listas v/vt/vn ficam na memoria, ja que uma face pode usar qualquer vertice anterior.
+	bool loadFileStreaming(const string& filename, const VertexFormat& format, size_t stagingSize,
+		const function<void(size_t nbVertices, const MeshBounds& bounds)>& beginUpload,
+		const function<void(const void* data, size_t offset, size_t size)>& upload,
+		size_t& nbVertices);
+
+	static const int FLOATS_PER_VERTEX = 11;
+	// Abaixo disso nao compensa criar threads
+	static const size_t MIN_CHUNK_SIZE = 256 * 1024;
+	// Bloco de leitura do loadFileStreaming (uma linha nao pode ser maior que isso)
+	static const size_t STREAM_BLOCK_SIZE = 1024 * 1024;
+
+protected:
+	bool readFile(const string& filename);
+
+	ObjMesh mesh;
+	vector<char> fileBuffer;
+
+	// Resultados parciais de cada bloco do parseParallel
+	vector<ObjMesh> chunks;
+	vector<vector<ObjFixup>> chunkFixups;
+};
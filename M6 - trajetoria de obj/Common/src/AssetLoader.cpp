@@ -0,0 +1,144 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <cstdio>
+
+static const char* STATE_NAMES[] = { "queued", "loading", "uploading", "ready", "failed" };
+
+static double elapsedMs(chrono::steady_clock::time_point from, chrono::steady_clock::time_point to)
+{
+	return chrono::duration<double, milli>(to - from).count();
+}
+
+AssetLoader::AssetLoader(int nbThreads) : stopping(false)
+{
+	for (int i = 0; i < max(nbThreads, 1); i++)
+	{
+		workers.emplace_back(&AssetLoader::workerLoop, this);
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		lock_guard<mutex> guard(queueLock);
+		stopping = true;
+		queue.clear();
+	}
+	queueChanged.notify_all();
+
+	for (thread& worker : workers)
+		worker.join();
+}
+
+int AssetLoader::load(const string& name, WorkFunction work, UploadFunction upload, bool uploadWhileLoading)
+{
+	unique_ptr<Asset> asset(new Asset());
+	asset->name = name;
+	asset->work = move(work);
+	asset->upload = move(upload);
+	asset->uploadWhileLoading = uploadWhileLoading;
+	asset->state = ASSET_QUEUED;
+	asset->requestTime = Clock::now();
+
+	{
+		lock_guard<mutex> guard(queueLock);
+		queue.push_back(asset.get());
+	}
+	queueChanged.notify_one();
+
+	assets.push_back(move(asset));
+
+	return assets.size() - 1;
+}
+
+void AssetLoader::workerLoop()
+{
+	while (true)
+	{
+		Asset* asset;
+		{
+			unique_lock<mutex> guard(queueLock);
+			queueChanged.wait(guard, [this]() { return stopping || !queue.empty(); });
+
+			if (stopping)
+				return;
+
+			asset = queue.front();
+			queue.pop_front();
+		}
+
+		asset->state = ASSET_LOADING;
+		bool ok = asset->work();
+		asset->workEndTime = Clock::now();
+		asset->state = ok ? ASSET_UPLOADING : ASSET_FAILED;
+	}
+}
+
+void AssetLoader::update(double budgetMs)
+{
+	Clock::time_point start = Clock::now();
+
+	for (unique_ptr<Asset>& asset : assets)
+	{
+		AssetState state = asset->state;
+		bool uploading = state == ASSET_UPLOADING || (state == ASSET_LOADING && asset->uploadWhileLoading);
+
+		while (uploading)
+		{
+			Clock::time_point callStart = Clock::now();
+			UploadResult result = asset->upload();
+			Clock::time_point callEnd = Clock::now();
+			asset->uploadTime += elapsedMs(callStart, callEnd);
+
+			// Produtor/consumidor: so termina depois que o work tambem terminou
+			if (result == UPLOAD_DONE && asset->state == ASSET_UPLOADING)
+			{
+				asset->readyTime = callEnd;
+				asset->state = ASSET_READY;
+				break;
+			}
+
+			if (result != UPLOAD_MORE || elapsedMs(start, callEnd) >= budgetMs)
+				break;
+		}
+
+		if (elapsedMs(start, Clock::now()) >= budgetMs)
+			break;
+	}
+}
+
+bool AssetLoader::isIdle() const
+{
+	for (const unique_ptr<Asset>& asset : assets)
+	{
+		if (asset->state != ASSET_READY && asset->state != ASSET_FAILED)
+			return false;
+	}
+	return true;
+}
+
+double AssetLoader::getWorkTime(int asset) const
+{
+	AssetState state = assets[asset]->state;
+	if (state == ASSET_QUEUED || state == ASSET_LOADING)
+		return -1.0;
+	return elapsedMs(assets[asset]->requestTime, assets[asset]->workEndTime);
+}
+
+double AssetLoader::getLoadTime(int asset) const
+{
+	if (assets[asset]->state != ASSET_READY)
+		return -1.0;
+	return elapsedMs(assets[asset]->requestTime, assets[asset]->readyTime);
+}
+
+void AssetLoader::printStats() const
+{
+	for (size_t i = 0; i < assets.size(); i++)
+	{
+		const Asset& asset = *assets[i];
+		printf("  %-40s %-9s work %8.1f ms  upload %6.1f ms  total %8.1f ms\n", asset.name.c_str(), STATE_NAMES[asset.state],
+			getWorkTime(i), asset.uploadTime, getLoadTime(i));
+	}
+}
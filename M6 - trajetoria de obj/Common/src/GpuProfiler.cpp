@@ -0,0 +1,216 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+GpuProfiler::~GpuProfiler()
+{
+	for (FrameQueries& queries : frames)
+	{
+		if (!queries.pool.empty())
+			glDeleteQueries((GLsizei)queries.pool.size(), queries.pool.data());
+	}
+}
+
+void GpuProfiler::beginFrame()
+{
+	advance(false);
+}
+
+void GpuProfiler::finish()
+{
+	for (int i = 0; i < PROFILER_LATENCY; i++)
+		advance(true);
+}
+
+void GpuProfiler::advance(bool wait)
+{
+	frame = (frame + 1) % PROFILER_LATENCY;
+
+	// As queries deste anel sao de PROFILER_LATENCY frames atras
+	FrameQueries& queries = frames[frame];
+	collect(queries, wait);
+	queries.nbUsed = 0;
+	queries.scopes.clear();
+
+	open.clear();
+}
+
+GLuint GpuProfiler::nextQuery(FrameQueries& queries)
+{
+	if (queries.nbUsed == queries.pool.size())
+	{
+		GLuint query;
+		glGenQueries(1, &query);
+		queries.pool.push_back(query);
+	}
+	return queries.pool[queries.nbUsed++];
+}
+
+void GpuProfiler::beginScope(const string& name)
+{
+	if (!enabled)
+		return;
+
+	auto found = scopeIds.find(name);
+	if (found == scopeIds.end())
+	{
+		found = scopeIds.emplace(name, (int)scopeSamples.size()).first;
+		scopeSamples.emplace_back();
+		scopeSamples.back().name = name;
+	}
+
+	FrameQueries& queries = frames[frame];
+	ScopeQuery scope;
+	scope.scope = found->second;
+	scope.begin = nextQuery(queries);
+	scope.end = 0;
+	scope.closed = false;
+	glQueryCounter(scope.begin, GL_TIMESTAMP);
+
+	open.push_back((int)queries.scopes.size());
+	queries.scopes.push_back(scope);
+}
+
+void GpuProfiler::endScope()
+{
+	if (!enabled || open.empty())
+		return;
+
+	FrameQueries& queries = frames[frame];
+	ScopeQuery& scope = queries.scopes[open.back()];
+	open.pop_back();
+
+	scope.end = nextQuery(queries);
+	scope.closed = true;
+	glQueryCounter(scope.end, GL_TIMESTAMP);
+}
+
+void GpuProfiler::collect(FrameQueries& queries, bool wait)
+{
+	if (queries.scopes.empty())
+		return;
+
+	// O slot vai ser reusado neste frame: sem os resultados, o frame fica sem amostra
+	// (um frame parcial somaria so parte dos escopos)
+	if (!wait)
+	{
+		for (const ScopeQuery& scope : queries.scopes)
+		{
+			if (!scope.closed)
+				continue;
+
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(scope.end, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				nbSkippedFrames++;
+				return;
+			}
+		}
+	}
+
+	frameTotals.assign(scopeSamples.size(), -1.0);
+
+	for (const ScopeQuery& scope : queries.scopes)
+	{
+		if (!scope.closed)
+			continue;
+
+		// Os timestamps terminam em ordem: com o end disponivel, o begin tambem esta
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &end);
+
+		double& total = frameTotals[scope.scope];
+		total = max(total, 0.0) + (end > begin ? (end - begin) / 1000000.0 : 0.0);
+	}
+
+	for (size_t i = 0; i < frameTotals.size(); i++)
+	{
+		if (frameTotals[i] < 0.0)
+			continue;
+
+		ScopeSamples& samples = scopeSamples[i];
+		if (samples.samples.size() < PROFILER_WINDOW)
+			samples.samples.push_back(frameTotals[i]);
+		else
+			samples.samples[samples.next] = frameTotals[i];
+		samples.next = (samples.next + 1) % PROFILER_WINDOW;
+	}
+}
+
+vector<GpuScopeStats> GpuProfiler::getStats() const
+{
+	vector<GpuScopeStats> stats;
+
+	for (const ScopeSamples& samples : scopeSamples)
+	{
+		GpuScopeStats scope;
+		scope.name = samples.name;
+		scope.nbSamples = samples.samples.size();
+
+		if (!samples.samples.empty())
+		{
+			vector<double> sorted = samples.samples;
+			sort(sorted.begin(), sorted.end());
+
+			double sum = 0.0;
+			for (double sample : sorted)
+				sum += sample;
+
+			scope.minMs = sorted.front();
+			scope.avgMs = sum / sorted.size();
+			scope.p99Ms = sorted[min(sorted.size() - 1, sorted.size() * 99 / 100)];
+		}
+		stats.push_back(scope);
+	}
+
+	return stats;
+}
+
+void GpuProfiler::clearStats()
+{
+	for (ScopeSamples& samples : scopeSamples)
+	{
+		samples.samples.clear();
+		samples.next = 0;
+	}
+	nbSkippedFrames = 0;
+}
+
+void GpuProfiler::report(ostream& out) const
+{
+	for (const GpuScopeStats& scope : getStats())
+	{
+		char line[256];
+		snprintf(line, sizeof(line), "%-10s min %7.3f ms  avg %7.3f ms  p99 %7.3f ms  (%zu frames)", scope.name.c_str(),
+			scope.minMs, scope.avgMs, scope.p99Ms, scope.nbSamples);
+		out << line << endl;
+	}
+
+	if (nbSkippedFrames > 0)
+		out << nbSkippedFrames << " frames skipped (GPU results not ready)" << endl;
+}
+
+bool GpuProfiler::appendCsv(const string& file, const string& run) const
+{
+	bool writeHeader = !ifstream(file).good();
+	ofstream csv(file, ios::app);
+	if (!csv)
+		return false;
+
+	if (writeHeader)
+		csv << "run,scope,frames,min_ms,avg_ms,p99_ms" << endl;
+
+	for (const GpuScopeStats& scope : getStats())
+	{
+		char line[256];
+		snprintf(line, sizeof(line), "%s,%s,%zu,%.4f,%.4f,%.4f", run.c_str(), scope.name.c_str(), scope.nbSamples,
+			scope.minMs, scope.avgMs, scope.p99Ms);
+		csv << line << endl;
+	}
+
+	return true;
+}
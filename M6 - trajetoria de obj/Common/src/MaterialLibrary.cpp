@@ -0,0 +1,74 @@
+#include "MaterialLibrary.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+bool MaterialLibrary::loadFile(const string& filename)
+{
+	ifstream file(filename);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fs::path folder = fs::path(filename).parent_path();
+	Material* material = nullptr;
+
+	string line;
+
+	while (getline(file, line))
+	{
+		istringstream iss(line);
+		string key, value;
+
+		if (!(iss >> key) || key[0] == '#')
+		{
+			continue;
+		}
+
+		iss >> value;
+
+		if (key == "newmtl")
+		{
+			materials.push_back(Material());
+			material = &materials.back();
+			material->name = value;
+			continue;
+		}
+
+		// Propriedades antes do primeiro newmtl ficam num material sem nome
+		if (!material)
+		{
+			materials.push_back(Material());
+			material = &materials.back();
+		}
+
+		error_code error;
+		bool isMap = key.compare(0, 4, "map_") == 0 || key == "bump" || key == "norm";
+		if (isMap && !value.empty() && !fs::exists(value, error) && fs::exists(folder / value, error))
+		{
+			value = (folder / value).string();
+		}
+
+		material->properties[key] = value;
+	}
+
+	return true;
+}
+
+int MaterialLibrary::find(const string& name) const
+{
+	for (int i = materials.size() - 1; i >= 0; i--)
+	{
+		if (materials[i].name == name)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
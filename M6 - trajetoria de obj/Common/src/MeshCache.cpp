@@ -0,0 +1,233 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+static uint64_t hashString(const string& value)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : value)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// Le count nomes terminados em '\0' de [p, end)
+static bool readNames(const char*& p, const char* end, uint32_t count, vector<string>& names)
+{
+	names.clear();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const char* nameEnd = (const char*)memchr(p, '\0', end - p);
+		if (!nameEnd)
+		{
+			return false;
+		}
+		names.emplace_back(p, nameEnd);
+		p = nameEnd + 1;
+	}
+	return true;
+}
+
+static void writeNames(string& strings, const vector<string>& names)
+{
+	for (const string& name : names)
+	{
+		strings += name;
+		strings += '\0';
+	}
+}
+
+static bool statSource(const string& sourcePath, uint64_t& size, int64_t& time)
+{
+	error_code error;
+	size = fs::file_size(sourcePath, error);
+	if (error)
+	{
+		return false;
+	}
+
+	time = fs::last_write_time(sourcePath, error).time_since_epoch().count();
+	return !error;
+}
+
+string MeshCache::getCachePath(const string& sourcePath) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)hashString(fs::absolute(sourcePath).string()));
+	return cacheDir + name;
+}
+
+bool MeshCache::open(const string& sourcePath)
+{
+	close();
+
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!statSource(sourcePath, sourceSize, sourceTime))
+	{
+		return false;
+	}
+
+	if (!file.open(getCachePath(sourcePath)) || file.getSize() < sizeof(MeshCacheHeader))
+	{
+		file.close();
+		return false;
+	}
+
+	const MeshCacheHeader* header = (const MeshCacheHeader*)file.getData();
+
+	bool valid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+		&& header->version == VERSION
+		&& header->sourcePathHash == hashString(fs::absolute(sourcePath).string())
+		&& header->sourceSize == sourceSize
+		&& header->sourceTime == sourceTime
+		&& header->vertexOffset + (uint64_t)header->vertexStride * header->nbVertices <= file.getSize()
+		&& header->indexOffset + sizeof(uint32_t) * header->nbIndices <= file.getSize()
+		&& header->submeshOffset + sizeof(Submesh) * header->nbSubmeshes <= file.getSize()
+		&& header->meshletOffset + sizeof(Meshlet) * header->nbMeshlets <= file.getSize()
+		&& header->lodOffset + sizeof(MeshLod) * header->nbLods <= file.getSize()
+		&& header->lodSubmeshOffset + sizeof(Submesh) * header->nbLodSubmeshes <= file.getSize()
+		&& header->stringsOffset + header->stringsSize <= file.getSize();
+
+	if (!valid)
+	{
+		file.close();
+		return false;
+	}
+
+	mesh.vertices = file.getData() + header->vertexOffset;
+	mesh.vertexFormat = header->vertexFormat;
+	mesh.vertexStride = header->vertexStride;
+	mesh.nbVertices = header->nbVertices;
+	mesh.indices = (const uint32_t*)(file.getData() + header->indexOffset);
+	mesh.nbIndices = header->nbIndices;
+	memcpy(mesh.bounds.min, header->boundsMin, sizeof(mesh.bounds.min));
+	memcpy(mesh.bounds.max, header->boundsMax, sizeof(mesh.bounds.max));
+
+	const Submesh* submeshes = (const Submesh*)(file.getData() + header->submeshOffset);
+	mesh.parts.submeshes.assign(submeshes, submeshes + header->nbSubmeshes);
+
+	const Meshlet* meshlets = (const Meshlet*)(file.getData() + header->meshletOffset);
+	mesh.parts.meshlets.assign(meshlets, meshlets + header->nbMeshlets);
+
+	const MeshLod* lods = (const MeshLod*)(file.getData() + header->lodOffset);
+	mesh.parts.lods.assign(lods, lods + header->nbLods);
+
+	const Submesh* lodSubmeshes = (const Submesh*)(file.getData() + header->lodSubmeshOffset);
+	mesh.parts.lodSubmeshes.assign(lodSubmeshes, lodSubmeshes + header->nbLodSubmeshes);
+
+	const char* strings = file.getData() + header->stringsOffset;
+	const char* stringsEnd = strings + header->stringsSize;
+
+	if (!readNames(strings, stringsEnd, header->nbObjectNames, mesh.parts.objectNames)
+		|| !readNames(strings, stringsEnd, header->nbMaterialNames, mesh.parts.materialNames)
+		|| !readNames(strings, stringsEnd, header->nbMaterialLibraries, mesh.parts.materialLibraries))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MeshCache::close()
+{
+	file.close();
+	mesh = CookedMesh();
+}
+
+bool MeshCache::write(const string& sourcePath, const CookedMesh& mesh)
+{
+	MeshCacheHeader out = {};
+	memcpy(out.magic, MAGIC, sizeof(MAGIC));
+	out.version = VERSION;
+	out.sourcePathHash = hashString(fs::absolute(sourcePath).string());
+
+	if (!statSource(sourcePath, out.sourceSize, out.sourceTime))
+	{
+		return false;
+	}
+
+	// Dados alinhados em 16 bytes para poderem ser lidos direto do mapeamento
+	out.vertexFormat = mesh.vertexFormat;
+	out.vertexStride = mesh.vertexStride;
+	out.nbVertices = mesh.nbVertices;
+	out.nbIndices = mesh.nbIndices;
+	memcpy(out.boundsMin, mesh.bounds.min, sizeof(out.boundsMin));
+	memcpy(out.boundsMax, mesh.bounds.max, sizeof(out.boundsMax));
+	out.vertexOffset = (sizeof(MeshCacheHeader) + 15) & ~15ull;
+	out.indexOffset = (out.vertexOffset + mesh.getVertexDataSize() + 15) & ~15ull;
+
+	string strings;
+	writeNames(strings, mesh.parts.objectNames);
+	writeNames(strings, mesh.parts.materialNames);
+	writeNames(strings, mesh.parts.materialLibraries);
+
+	out.nbSubmeshes = mesh.parts.submeshes.size();
+	out.nbObjectNames = mesh.parts.objectNames.size();
+	out.nbMaterialNames = mesh.parts.materialNames.size();
+	out.nbMaterialLibraries = mesh.parts.materialLibraries.size();
+	out.nbMeshlets = mesh.parts.meshlets.size();
+	out.nbLods = mesh.parts.lods.size();
+	out.nbLodSubmeshes = mesh.parts.lodSubmeshes.size();
+	out.submeshOffset = (out.indexOffset + mesh.getIndexDataSize() + 15) & ~15ull;
+	out.meshletOffset = (out.submeshOffset + sizeof(Submesh) * out.nbSubmeshes + 15) & ~15ull;
+	out.lodOffset = (out.meshletOffset + sizeof(Meshlet) * out.nbMeshlets + 15) & ~15ull;
+	out.lodSubmeshOffset = (out.lodOffset + sizeof(MeshLod) * out.nbLods + 15) & ~15ull;
+	out.stringsOffset = out.lodSubmeshOffset + sizeof(Submesh) * out.nbLodSubmeshes;
+	out.stringsSize = strings.size();
+
+	error_code error;
+	fs::create_directories(cacheDir, error);
+
+	// Grava num arquivo temporario e renomeia, para nunca deixar um cache pela metade
+	string cachePath = getCachePath(sourcePath);
+	string tempPath = cachePath + ".tmp";
+
+	ofstream cacheFile(tempPath, ios::binary | ios::trunc);
+	if (!cacheFile.is_open())
+	{
+		return false;
+	}
+
+	static const char padding[16] = {};
+
+	cacheFile.write((const char*)&out, sizeof(out));
+	cacheFile.write(padding, out.vertexOffset - sizeof(out));
+	cacheFile.write((const char*)mesh.vertices, mesh.getVertexDataSize());
+	cacheFile.write(padding, out.indexOffset - (out.vertexOffset + mesh.getVertexDataSize()));
+	if (mesh.nbIndices > 0)
+	{
+		cacheFile.write((const char*)mesh.indices, mesh.getIndexDataSize());
+	}
+	cacheFile.write(padding, out.submeshOffset - (out.indexOffset + mesh.getIndexDataSize()));
+	cacheFile.write((const char*)mesh.parts.submeshes.data(), sizeof(Submesh) * out.nbSubmeshes);
+	cacheFile.write(padding, out.meshletOffset - (out.submeshOffset + sizeof(Submesh) * out.nbSubmeshes));
+	cacheFile.write((const char*)mesh.parts.meshlets.data(), sizeof(Meshlet) * out.nbMeshlets);
+	cacheFile.write(padding, out.lodOffset - (out.meshletOffset + sizeof(Meshlet) * out.nbMeshlets));
+	cacheFile.write((const char*)mesh.parts.lods.data(), sizeof(MeshLod) * out.nbLods);
+	cacheFile.write(padding, out.lodSubmeshOffset - (out.lodOffset + sizeof(MeshLod) * out.nbLods));
+	cacheFile.write((const char*)mesh.parts.lodSubmeshes.data(), sizeof(Submesh) * out.nbLodSubmeshes);
+	cacheFile.write(strings.data(), strings.size());
+	cacheFile.close();
+
+	if (!cacheFile)
+	{
+		fs::remove(tempPath, error);
+		return false;
+	}
+
+	fs::rename(tempPath, cachePath, error);
+
+	return !error;
+}
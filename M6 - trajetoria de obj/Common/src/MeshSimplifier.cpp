@@ -0,0 +1,541 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+#include <glm/glm.hpp>
+
+static const unsigned int UNUSED = 0xFFFFFFFFu;
+
+// Peso dos planos que prendem as bordas abertas (e as divisas entre submeshes)
+static const double BORDER_WEIGHT = 10.0;
+
+// Um colapso que gira a normal de algum triangulo alem disso (cosseno) e recusado
+static const double MIN_NORMAL_DOT = 0.2;
+
+// Forma quadratica simetrica 4x4: soma dos quadrados das distancias a um conjunto de
+// planos, cada um com um peso (area do triangulo); weight e a soma dos pesos
+struct Quadric
+{
+	double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+	double weight = 0;
+
+	void addPlane(glm::dvec3 n, double d, double weight)
+	{
+		xx += weight * n.x * n.x; xy += weight * n.x * n.y; xz += weight * n.x * n.z; xw += weight * n.x * d;
+		yy += weight * n.y * n.y; yz += weight * n.y * n.z; yw += weight * n.y * d;
+		zz += weight * n.z * n.z; zw += weight * n.z * d;
+		ww += weight * d * d;
+		this->weight += weight;
+	}
+
+	void add(const Quadric& q)
+	{
+		xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw; yy += q.yy;
+		yz += q.yz; yw += q.yw; zz += q.zz; zw += q.zw; ww += q.ww;
+		weight += q.weight;
+	}
+
+	double evaluate(glm::dvec3 p) const
+	{
+		double value = xx * p.x * p.x + 2 * xy * p.x * p.y + 2 * xz * p.x * p.z + 2 * xw * p.x
+			+ yy * p.y * p.y + 2 * yz * p.y * p.z + 2 * yw * p.y
+			+ zz * p.z * p.z + 2 * zw * p.z + ww;
+		return max(value, 0.0);
+	}
+
+	// Media ponderada dos quadrados das distancias: nao cresce so porque os planos se
+	// acumulam nos colapsos
+	double error(glm::dvec3 p) const
+	{
+		return weight > 0 ? evaluate(p) / weight : 0.0;
+	}
+};
+
+struct SimplifierTriangle
+{
+	unsigned int position[3]; // vertice soldado (posicao)
+	unsigned int vertex[3];   // vertice do VBO (posicao + atributos), id local
+	unsigned int group;       // submesh de onde o triangulo veio
+	bool alive;
+};
+
+struct Collapse
+{
+	double cost;
+	unsigned int from, to;
+	unsigned int fromVersion, toVersion;
+
+	bool operator<(const Collapse& other) const { return cost > other.cost; } // menor custo primeiro
+};
+
+// Estado de uma simplificacao. As posicoes soldadas sao os vertices do grafo; os
+// vertices do VBO so aparecem nos cantos dos triangulos.
+class Simplifier
+{
+public:
+	// groups: submesh de cada triangulo (nullptr = todos no mesmo); a divisa entre dois
+	// grupos e tratada como borda
+	Simplifier(const unsigned int* indices, size_t nbIndices, const unsigned int* groups, const float* positions, size_t positionStride,
+		const float* attributes, size_t nbAttributes, size_t nbVertices);
+
+	void run(size_t targetTriangles);
+	// Grava os triangulos de um grupo e retorna quantos indices foram gravados
+	size_t write(unsigned int* destination, unsigned int group) const;
+	double getMaxCost() const { return maxCost; }
+
+protected:
+	void computeQuadrics();
+	void pushCollapses(unsigned int position);
+	bool canCollapse(unsigned int from, unsigned int to);
+	void collapse(unsigned int from, unsigned int to);
+	unsigned int closestVariant(unsigned int vertex, unsigned int position) const;
+	glm::dvec3 getNormal(const SimplifierTriangle& triangle) const;
+
+	const float* attributes;
+	size_t nbAttributes;
+
+	vector<unsigned int> localToGlobal;  // vertice local -> indice original
+	vector<unsigned int> positionOfVertex;
+	vector<glm::dvec3> points;           // uma por posicao soldada
+	vector<vector<unsigned int>> variants; // vertices locais de cada posicao
+	vector<vector<unsigned int>> adjacency; // triangulos de cada posicao (inclui os mortos)
+	vector<Quadric> quadrics;
+	vector<unsigned int> versions;
+	vector<bool> removed;
+	vector<bool> border;                 // posicao numa borda aberta ou divisa de grupos
+	vector<unsigned int> marks;
+	unsigned int markId = 0;
+
+	vector<SimplifierTriangle> triangles;
+	size_t nbAlive = 0;
+	priority_queue<Collapse> queue;
+	double maxCost = 0.0;
+};
+
+Simplifier::Simplifier(const unsigned int* indices, size_t nbIndices, const unsigned int* groups, const float* positions, size_t positionStride,
+	const float* attributes, size_t nbAttributes, size_t nbVertices)
+	: attributes(attributes), nbAttributes(nbAttributes)
+{
+	// Ids locais para os vertices e para as posicoes distintas (costuras soldadas)
+	vector<unsigned int> globalToLocal(nbVertices, UNUSED);
+	vector<pair<glm::vec3, unsigned int>> sorted;
+
+	for (size_t i = 0; i < nbIndices; i++)
+	{
+		unsigned int vertex = indices[i];
+		if (globalToLocal[vertex] == UNUSED)
+		{
+			globalToLocal[vertex] = localToGlobal.size();
+			localToGlobal.push_back(vertex);
+
+			const float* p = (const float*)((const unsigned char*)positions + vertex * positionStride);
+			sorted.push_back({ glm::vec3(p[0], p[1], p[2]), globalToLocal[vertex] });
+		}
+	}
+
+	sort(sorted.begin(), sorted.end(), [](const pair<glm::vec3, unsigned int>& a, const pair<glm::vec3, unsigned int>& b) {
+		if (a.first.x != b.first.x) return a.first.x < b.first.x;
+		if (a.first.y != b.first.y) return a.first.y < b.first.y;
+		return a.first.z < b.first.z;
+	});
+
+	positionOfVertex.resize(localToGlobal.size());
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		if (i == 0 || sorted[i].first != sorted[i - 1].first)
+		{
+			points.push_back(glm::dvec3(sorted[i].first));
+			variants.emplace_back();
+		}
+		positionOfVertex[sorted[i].second] = points.size() - 1;
+		variants.back().push_back(sorted[i].second);
+	}
+
+	adjacency.resize(points.size());
+	quadrics.resize(points.size());
+	versions.assign(points.size(), 0);
+	removed.assign(points.size(), false);
+	border.assign(points.size(), false);
+	marks.assign(points.size(), 0);
+
+	for (size_t i = 0; i + 2 < nbIndices; i += 3)
+	{
+		SimplifierTriangle triangle;
+		for (int k = 0; k < 3; k++)
+		{
+			triangle.vertex[k] = globalToLocal[indices[i + k]];
+			triangle.position[k] = positionOfVertex[triangle.vertex[k]];
+		}
+		triangle.group = groups ? groups[i / 3] : 0;
+
+		// Triangulos degenerados (mesma posicao em dois cantos) ficam de fora
+		triangle.alive = triangle.position[0] != triangle.position[1] && triangle.position[1] != triangle.position[2]
+			&& triangle.position[2] != triangle.position[0];
+		if (!triangle.alive)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+			adjacency[triangle.position[k]].push_back(triangles.size());
+		triangles.push_back(triangle);
+	}
+
+	nbAlive = triangles.size();
+	computeQuadrics();
+}
+
+glm::dvec3 Simplifier::getNormal(const SimplifierTriangle& triangle) const
+{
+	const glm::dvec3& p0 = points[triangle.position[0]];
+	return glm::cross(points[triangle.position[1]] - p0, points[triangle.position[2]] - p0);
+}
+
+// Planos dos triangulos e, nas arestas usadas por um triangulo so do seu grupo, um
+// plano perpendicular que segura a borda no lugar
+void Simplifier::computeQuadrics()
+{
+	for (const SimplifierTriangle& triangle : triangles)
+	{
+		glm::dvec3 normal = getNormal(triangle);
+		double length = glm::length(normal);
+		if (length == 0.0)
+			continue;
+		normal /= length;
+
+		// Peso pela area: triangulos pequenos quase nao mudam a superficie
+		double d = -glm::dot(normal, points[triangle.position[0]]);
+		for (int k = 0; k < 3; k++)
+			quadrics[triangle.position[k]].addPlane(normal, d, length * 0.5);
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int a = triangle.position[k], b = triangle.position[(k + 1) % 3];
+
+			// A aresta b -> a em outro triangulo do mesmo grupo fecha a borda
+			bool shared = false;
+			for (unsigned int other : adjacency[b])
+			{
+				const SimplifierTriangle& t = triangles[other];
+				for (int j = 0; j < 3 && !shared && t.group == triangle.group; j++)
+					shared = t.position[j] == b && t.position[(j + 1) % 3] == a;
+				if (shared)
+					break;
+			}
+			if (shared)
+				continue;
+
+			border[a] = border[b] = true;
+
+			glm::dvec3 edge = points[b] - points[a];
+			glm::dvec3 borderNormal = glm::cross(edge, normal);
+			double borderLength = glm::length(borderNormal);
+			if (borderLength == 0.0)
+				continue;
+			borderNormal /= borderLength;
+
+			double borderD = -glm::dot(borderNormal, points[a]);
+			double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+			quadrics[a].addPlane(borderNormal, borderD, weight);
+			quadrics[b].addPlane(borderNormal, borderD, weight);
+		}
+	}
+}
+
+void Simplifier::pushCollapses(unsigned int position)
+{
+	// Cada vizinho entra uma vez, mesmo aparecendo em dois triangulos
+	markId++;
+
+	for (unsigned int t : adjacency[position])
+	{
+		const SimplifierTriangle& triangle = triangles[t];
+		if (!triangle.alive)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int other = triangle.position[k];
+			if (other == position || marks[other] == markId)
+				continue;
+			marks[other] = markId;
+
+			Quadric q = quadrics[position];
+			q.add(quadrics[other]);
+
+			queue.push({ q.error(points[other]), position, other, versions[position], versions[other] });
+			queue.push({ q.error(points[position]), other, position, versions[other], versions[position] });
+		}
+	}
+}
+
+// Condicao de ligacao (a malha continua manifold), nenhum triangulo virado e nenhum
+// triangulo so de cantos na borda removido: numa malha aberta, o que sobra quando todos
+// os vertices estao na borda e o contorno, e tira-lo deixaria o nivel vazio
+bool Simplifier::canCollapse(unsigned int from, unsigned int to)
+{
+	markId++;
+	size_t nbShared = 0;
+
+	for (unsigned int t : adjacency[from])
+	{
+		const SimplifierTriangle& triangle = triangles[t];
+		if (!triangle.alive)
+			continue;
+
+		bool hasTo = false;
+		bool onBorder = true;
+		for (int k = 0; k < 3; k++)
+		{
+			marks[triangle.position[k]] = markId;
+			hasTo = hasTo || triangle.position[k] == to;
+			onBorder = onBorder && border[triangle.position[k]];
+		}
+		nbShared += hasTo;
+
+		if (hasTo)
+		{
+			if (onBorder)
+				return false;
+			continue;
+		}
+
+		glm::dvec3 before = getNormal(triangle);
+		SimplifierTriangle moved = triangle;
+		for (int k = 0; k < 3; k++)
+		{
+			if (moved.position[k] == from)
+				moved.position[k] = to;
+		}
+		glm::dvec3 after = getNormal(moved);
+
+		double lengths = glm::length(before) * glm::length(after);
+		if (lengths == 0.0 || glm::dot(before, after) < MIN_NORMAL_DOT * lengths)
+			return false;
+	}
+
+	// Vizinhos em comum: so os cantos opostos dos triangulos que somem
+	size_t nbCommon = 0;
+	markId++;
+	unsigned int fromMark = markId - 1;
+
+	for (unsigned int t : adjacency[to])
+	{
+		const SimplifierTriangle& triangle = triangles[t];
+		if (!triangle.alive)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int neighbor = triangle.position[k];
+			if (neighbor != from && neighbor != to && marks[neighbor] == fromMark)
+			{
+				marks[neighbor] = markId;
+				nbCommon++;
+			}
+		}
+	}
+
+	return nbCommon == nbShared;
+}
+
+// Variante (vertice do VBO) da posicao com os atributos mais parecidos com os de vertex
+unsigned int Simplifier::closestVariant(unsigned int vertex, unsigned int position) const
+{
+	const vector<unsigned int>& candidates = variants[position];
+	if (candidates.size() == 1 || !attributes)
+		return candidates[0];
+
+	const float* reference = attributes + (size_t)localToGlobal[vertex] * nbAttributes;
+	unsigned int best = candidates[0];
+	float bestDistance = -1.0f;
+
+	for (unsigned int candidate : candidates)
+	{
+		const float* values = attributes + (size_t)localToGlobal[candidate] * nbAttributes;
+		float distance = 0.0f;
+		for (size_t i = 0; i < nbAttributes; i++)
+			distance += (values[i] - reference[i]) * (values[i] - reference[i]);
+
+		if (bestDistance < 0.0f || distance < bestDistance)
+		{
+			best = candidate;
+			bestDistance = distance;
+		}
+	}
+
+	return best;
+}
+
+void Simplifier::collapse(unsigned int from, unsigned int to)
+{
+	for (unsigned int t : adjacency[from])
+	{
+		SimplifierTriangle& triangle = triangles[t];
+		if (!triangle.alive)
+			continue;
+
+		int corner = 0;
+		bool hasTo = false;
+		for (int k = 0; k < 3; k++)
+		{
+			if (triangle.position[k] == from)
+				corner = k;
+			hasTo = hasTo || triangle.position[k] == to;
+		}
+
+		if (hasTo)
+		{
+			triangle.alive = false;
+			nbAlive--;
+			continue;
+		}
+
+		triangle.position[corner] = to;
+		triangle.vertex[corner] = closestVariant(triangle.vertex[corner], to);
+		adjacency[to].push_back(t);
+	}
+
+	quadrics[to].add(quadrics[from]);
+	border[to] = border[to] || border[from];
+	removed[from] = true;
+	adjacency[from].clear();
+	versions[to]++;
+
+	// Tira da lista os triangulos que morreram
+	vector<unsigned int>& list = adjacency[to];
+	list.erase(remove_if(list.begin(), list.end(), [this](unsigned int t) { return !triangles[t].alive; }), list.end());
+
+	pushCollapses(to);
+}
+
+void Simplifier::run(size_t targetTriangles)
+{
+	// Colapsos iniciais: cada aresta entra uma vez, pelo canto de menor id
+	for (unsigned int position = 0; position < points.size(); position++)
+	{
+		markId++;
+
+		for (unsigned int t : adjacency[position])
+		{
+			const SimplifierTriangle& triangle = triangles[t];
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int other = triangle.position[k];
+				if (other <= position || marks[other] == markId)
+					continue;
+				marks[other] = markId;
+
+				Quadric q = quadrics[position];
+				q.add(quadrics[other]);
+				queue.push({ q.error(points[other]), position, other, 0, 0 });
+				queue.push({ q.error(points[position]), other, position, 0, 0 });
+			}
+		}
+	}
+
+	while (nbAlive > targetTriangles && !queue.empty())
+	{
+		Collapse next = queue.top();
+		queue.pop();
+
+		if (removed[next.from] || removed[next.to] || versions[next.from] != next.fromVersion || versions[next.to] != next.toVersion)
+			continue;
+		if (!canCollapse(next.from, next.to))
+			continue;
+
+		collapse(next.from, next.to);
+		maxCost = max(maxCost, next.cost);
+	}
+}
+
+size_t Simplifier::write(unsigned int* destination, unsigned int group) const
+{
+	size_t nbIndices = 0;
+
+	for (const SimplifierTriangle& triangle : triangles)
+	{
+		if (!triangle.alive || triangle.group != group)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+			destination[nbIndices++] = localToGlobal[triangle.vertex[k]];
+	}
+
+	return nbIndices;
+}
+
+size_t simplifyMesh(unsigned int* destination, const unsigned int* indices, size_t nbIndices, const float* positions, size_t positionStride,
+	const float* attributes, size_t nbAttributes, size_t nbVertices, size_t targetIndices, float& error)
+{
+	Simplifier simplifier(indices, nbIndices, nullptr, positions, positionStride, attributes, nbAttributes, nbVertices);
+	simplifier.run(targetIndices / 3);
+
+	// Raiz da media dos quadrados das distancias aos planos do pior colapso
+	error = (float)sqrt(simplifier.getMaxCost());
+
+	return simplifier.write(destination, 0);
+}
+
+void buildLods(vector<unsigned int>& indices, MeshParts& parts, const float* positions, size_t positionStride,
+	const float* attributes, size_t nbAttributes, size_t nbVertices)
+{
+	parts.lods.clear();
+	parts.lodSubmeshes.clear();
+
+	// Cada nivel simplifica todas as submeshes juntas: os colapsos mais baratos da malha
+	// inteira vem primeiro, em vez de forcar cada parte pequena a perder metade
+	vector<Submesh> previous = parts.submeshes;
+	vector<unsigned int> source, groups;
+	size_t previousTriangles = 0;
+	float previousError = 0.0f;
+
+	for (const Submesh& submesh : previous)
+		previousTriangles += submesh.nbIndices / 3;
+
+	for (int level = 1; level <= MAX_LODS && previousTriangles > 0; level++)
+	{
+		source.clear();
+		groups.clear();
+		for (size_t i = 0; i < previous.size(); i++)
+		{
+			source.insert(source.end(), indices.begin() + previous[i].firstIndex, indices.begin() + previous[i].firstIndex + previous[i].nbIndices);
+			groups.insert(groups.end(), previous[i].nbIndices / 3, (unsigned int)i);
+		}
+
+		Simplifier simplifier(source.data(), source.size(), groups.data(), positions, positionStride, attributes, nbAttributes, nbVertices);
+		simplifier.run((size_t)(previousTriangles * LOD_REDUCTION));
+
+		size_t levelStart = indices.size();
+		indices.resize(levelStart + source.size());
+
+		vector<Submesh> current;
+		size_t nbIndices = levelStart;
+		for (size_t i = 0; i < previous.size(); i++)
+		{
+			Submesh simplified = previous[i];
+			simplified.firstIndex = nbIndices;
+			simplified.nbIndices = simplifier.write(&indices[nbIndices], i);
+			nbIndices += simplified.nbIndices;
+			current.push_back(simplified);
+		}
+		indices.resize(nbIndices);
+
+		// Um nivel vazio nao desenharia nada: a cadeia acaba no anterior
+		size_t nbTriangles = (nbIndices - levelStart) / 3;
+		if (nbTriangles == 0 || nbTriangles > previousTriangles * (1.0f - MIN_LOD_REDUCTION))
+		{
+			indices.resize(levelStart);
+			break;
+		}
+
+		// O erro de um nivel soma o do nivel de onde ele saiu
+		float error = previousError + (float)sqrt(simplifier.getMaxCost());
+		parts.lods.push_back({ (uint32_t)parts.lodSubmeshes.size(), (uint32_t)current.size(), (uint32_t)nbTriangles, error });
+		parts.lodSubmeshes.insert(parts.lodSubmeshes.end(), current.begin(), current.end());
+
+		previous = current;
+		previousTriangles = nbTriangles;
+		previousError = error;
+	}
+}
@@ -0,0 +1,253 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Abaixo disso o cone de normais abre demais para descartar alguma coisa
+static const float MIN_CONE_DOT = 0.1f;
+
+// Um triangulo a mais de 60 graus da normal media do meshlet comeca outro meshlet:
+// sem isso o cone abre demais e quase nada e descartado pelo verso
+static const float MAX_NORMAL_SPREAD_DOT = 0.5f;
+
+static const unsigned int UNUSED = 0xFFFFFFFFu;
+
+static glm::vec3 getPosition(const float* positions, size_t positionStride, unsigned int vertex)
+{
+	const float* p = (const float*)((const unsigned char*)positions + vertex * positionStride);
+	return glm::vec3(p[0], p[1], p[2]);
+}
+
+// Esfera pela AABB dos vertices e cone pela media das normais dos triangulos
+static Meshlet computeMeshlet(const unsigned int* indices, size_t first, size_t count, const float* positions, size_t positionStride,
+	bool closed)
+{
+	Meshlet meshlet;
+	meshlet.firstIndex = first;
+	meshlet.nbIndices = count;
+
+	glm::vec3 boundsMin = getPosition(positions, positionStride, indices[first]);
+	glm::vec3 boundsMax = boundsMin;
+
+	for (size_t i = first; i < first + count; i++)
+	{
+		glm::vec3 p = getPosition(positions, positionStride, indices[i]);
+		boundsMin = glm::min(boundsMin, p);
+		boundsMax = glm::max(boundsMax, p);
+	}
+
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+
+	for (size_t i = first; i < first + count; i++)
+		radius = max(radius, glm::length(getPosition(positions, positionStride, indices[i]) - center));
+
+	vector<glm::vec3> normals;
+	glm::vec3 normalSum(0.0f);
+
+	for (size_t i = first; i < first + count; i += 3)
+	{
+		glm::vec3 p0 = getPosition(positions, positionStride, indices[i]);
+		glm::vec3 p1 = getPosition(positions, positionStride, indices[i + 1]);
+		glm::vec3 p2 = getPosition(positions, positionStride, indices[i + 2]);
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		if (length == 0.0f)
+			continue;
+
+		normals.push_back(normal / length);
+		normalSum += normals.back();
+	}
+
+	glm::vec3 axis(0.0f, 0.0f, 1.0f);
+	float minDot = -1.0f;
+
+	if (closed && glm::length(normalSum) > 0.0f)
+	{
+		axis = glm::normalize(normalSum);
+		minDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+			minDot = min(minDot, glm::dot(normal, axis));
+	}
+
+	memcpy(meshlet.center, &center[0], sizeof(meshlet.center));
+	meshlet.radius = radius;
+	memcpy(meshlet.coneAxis, &axis[0], sizeof(meshlet.coneAxis));
+	meshlet.coneCutoff = minDot > MIN_CONE_DOT ? sqrt(1.0f - minDot * minDot) : 1.0f;
+
+	return meshlet;
+}
+
+void buildMeshlets(const unsigned int* indices, size_t nbIndices, const vector<IndexRange>& ranges, const float* positions,
+	size_t positionStride, size_t nbVertices, vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+	bool closed = isClosedMesh(indices, nbIndices, positions, positionStride, nbVertices);
+
+	vector<IndexRange> allRanges = ranges;
+	if (allRanges.empty())
+		allRanges.push_back({ 0, nbIndices });
+
+	// Vertice ja esta no meshlet atual quando owner[vertice] == meshletId
+	vector<unsigned int> owner(nbVertices, UNUSED);
+	unsigned int meshletId = 0;
+
+	for (const IndexRange& range : allRanges)
+	{
+		size_t first = range.first;
+		size_t end = range.first + range.count;
+		size_t nbMeshletVertices = 0;
+		glm::vec3 normalSum(0.0f);
+
+		for (size_t i = range.first; i < end; i += 3)
+		{
+			unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+
+			size_t nbNew = (owner[a] != meshletId) + (owner[b] != meshletId && b != a) + (owner[c] != meshletId && c != a && c != b);
+			size_t nbTriangles = (i - first) / 3;
+
+			glm::vec3 p0 = getPosition(positions, positionStride, a);
+			glm::vec3 normal = glm::cross(getPosition(positions, positionStride, b) - p0, getPosition(positions, positionStride, c) - p0);
+			if (glm::length(normal) > 0.0f)
+				normal = glm::normalize(normal);
+
+			bool spread = closed && glm::length(normalSum) > 0.0f && glm::length(normal) > 0.0f
+				&& glm::dot(normal, glm::normalize(normalSum)) < MAX_NORMAL_SPREAD_DOT;
+
+			if (nbTriangles > 0 && (spread || nbMeshletVertices + nbNew > MESHLET_MAX_VERTICES || nbTriangles == MESHLET_MAX_TRIANGLES))
+			{
+				meshlets.push_back(computeMeshlet(indices, first, i - first, positions, positionStride, closed));
+				meshletId++;
+				first = i;
+				nbMeshletVertices = 0;
+				nbNew = 1 + (b != a) + (c != a && c != b);
+				normalSum = glm::vec3(0.0f);
+			}
+
+			owner[a] = owner[b] = owner[c] = meshletId;
+			nbMeshletVertices += nbNew;
+			normalSum += normal;
+		}
+
+		if (end > first)
+		{
+			meshlets.push_back(computeMeshlet(indices, first, end - first, positions, positionStride, closed));
+			meshletId++;
+		}
+	}
+}
+
+// Tabela hash de enderecamento aberto para isClosedMesh (chaves 0 nao sao usadas)
+template <typename Key>
+static size_t findSlot(const vector<Key>& keys, const Key& key, size_t hash)
+{
+	size_t mask = keys.size() - 1;
+	size_t slot = hash & mask;
+
+	while (keys[slot] != Key() && keys[slot] != key)
+		slot = (slot + 1) & mask;
+
+	return slot;
+}
+
+bool isClosedMesh(const unsigned int* indices, size_t nbIndices, const float* positions, size_t positionStride, size_t nbVertices)
+{
+	if (nbIndices == 0)
+		return false;
+
+	size_t capacity = 16;
+	while (capacity < max(nbVertices, nbIndices) * 2)
+		capacity <<= 1;
+
+	// Vertices na mesma posicao (comparando os bits dos floats) viram um so. A chave
+	// guarda a posicao com um bit a mais, para nunca ser toda zero.
+	typedef array<uint32_t, 4> PositionKey;
+	vector<PositionKey> positionKeys(capacity);
+	vector<unsigned int> positionIds(capacity);
+	vector<unsigned int> weldedIds(nbVertices);
+	unsigned int nbWelded = 0;
+
+	for (size_t v = 0; v < nbVertices; v++)
+	{
+		glm::vec3 p = getPosition(positions, positionStride, v) + glm::vec3(0.0f); // -0 vira +0
+		PositionKey key = { 1, 0, 0, 0 };
+		memcpy(&key[1], &p[0], 3 * sizeof(float));
+
+		size_t slot = findSlot(positionKeys, key, (key[1] * 73856093u) ^ (key[2] * 19349663u) ^ (key[3] * 83492791u));
+		if (positionKeys[slot] == PositionKey())
+		{
+			positionKeys[slot] = key;
+			positionIds[slot] = nbWelded++;
+		}
+		weldedIds[v] = positionIds[slot];
+	}
+
+	// Cada aresta (sem orientacao) soma +1 no sentido a -> b e -1 no sentido b -> a:
+	// numa malha fechada todas terminam em zero
+	vector<uint64_t> edgeKeys(capacity);
+	vector<int> balance(capacity, 0);
+
+	for (size_t i = 0; i + 2 < nbIndices; i += 3)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			uint64_t a = weldedIds[indices[i + k]];
+			uint64_t b = weldedIds[indices[i + (k + 1) % 3]];
+			if (a == b)
+				continue;
+
+			uint64_t key = (min(a, b) << 32 | max(a, b)) + 1;
+			size_t slot = findSlot(edgeKeys, key, (size_t)(key * 0x9E3779B97F4A7C15ull >> 32));
+			edgeKeys[slot] = key;
+			balance[slot] += a < b ? 1 : -1;
+		}
+	}
+
+	for (int value : balance)
+	{
+		if (value != 0)
+			return false;
+	}
+
+	return true;
+}
+
+void ClusterCuller::setup(const glm::mat4& projectionView, const glm::mat4& model, glm::vec3 cameraPosition)
+{
+	// Planos tirados das linhas da matriz (Gribb e Hartmann), ja no espaco do objeto
+	glm::mat4 m = projectionView * model;
+
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+		glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+		planes[i * 2] = w + row;
+		planes[i * 2 + 1] = w - row;
+	}
+
+	for (glm::vec4& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+}
+
+bool ClusterCuller::isVisible(const Meshlet& meshlet) const
+{
+	glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+
+	for (const glm::vec4& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -meshlet.radius)
+			return false;
+	}
+
+	// Todos os triangulos de costas para a camera, de qualquer ponto da esfera
+	glm::vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+	glm::vec3 toCenter = center - camera;
+
+	return glm::dot(toCenter, axis) < meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
@@ -0,0 +1,89 @@
+#include "ShaderManager.h"
+
+static const char* FEATURE_NAMES[] = { "FEATURE_TEXTURE", "FEATURE_SPECULAR", "FEATURE_NORMAL_MAP", "FEATURE_ALPHA_TEST" };
+
+string getFeatureDefines(unsigned features)
+{
+	string defines;
+	for (unsigned i = 0; i < sizeof(FEATURE_NAMES) / sizeof(FEATURE_NAMES[0]); i++)
+	{
+		if (features & (1u << i))
+			defines += string("#define ") + FEATURE_NAMES[i] + "\n";
+	}
+	return defines;
+}
+
+ShaderManager::ShaderManager(const GLchar* fallbackVertexPath, const GLchar* fallbackFragmentPath)
+{
+	// 0xFFFFFFFF = o driver escolhe quantas threads usar
+	if (hasParallelCompile())
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+	fallback.reset(new Shader(fallbackVertexPath, fallbackFragmentPath));
+}
+
+ProgramHandle ShaderManager::add(const GLchar* vertexPath, const GLchar* fragmentPath, const string& defines)
+{
+	programs.emplace_back(new Shader(vertexPath, fragmentPath, false, defines));
+	linked.push_back(false);
+	nbPending++;
+
+	return (ProgramHandle)programs.size() - 1;
+}
+
+ProgramHandle ShaderManager::getVariant(const string& vertexPath, const string& fragmentPath, unsigned features)
+{
+	string key = vertexPath + "|" + fragmentPath + "|" + to_string(features);
+
+	auto found = variants.find(key);
+	if (found != variants.end())
+		return found->second;
+
+	ProgramHandle program = add(vertexPath.c_str(), fragmentPath.c_str(), getFeatureDefines(features));
+	variants[key] = program;
+	return program;
+}
+
+void ShaderManager::finish(ProgramHandle program)
+{
+	linked[program] = programs[program]->finish();
+	nbPending--;
+}
+
+void ShaderManager::update()
+{
+	bool finishedOne = false;
+
+	for (size_t i = 0; i < programs.size(); i++)
+	{
+		if (!programs[i]->isPending())
+			continue;
+
+		if (programs[i]->isComplete())
+			finish((ProgramHandle)i);
+		else if (!hasParallelCompile() && !finishedOne)
+		{
+			finish((ProgramHandle)i);
+			finishedOne = true;
+		}
+	}
+}
+
+void ShaderManager::finishAll()
+{
+	for (size_t i = 0; i < programs.size(); i++)
+	{
+		if (programs[i]->isPending())
+			finish((ProgramHandle)i);
+	}
+}
+
+Shader& ShaderManager::get(ProgramHandle program)
+{
+	return isReady(program) ? *programs[program] : *fallback;
+}
+
+bool ShaderManager::isReady(ProgramHandle program) const
+{
+	return program >= 0 && program < (ProgramHandle)programs.size() && !programs[program]->isPending() && linked[program];
+}
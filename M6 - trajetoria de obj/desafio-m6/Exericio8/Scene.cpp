@@ -0,0 +1,916 @@
+#include "Scene.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <filesystem>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "stb_image.h"
+#include "ObjLoader.h"
+
+// Arquivos a partir desse tamanho sao carregados em streaming, com memoria limitada
+const uintmax_t STREAMING_THRESHOLD = 64 * 1024 * 1024;
+// Tamanho de cada bloco de vertices produzido pelo loader em streaming
+const size_t STAGING_SIZE = 4 * 1024 * 1024;
+// Blocos do streaming que podem esperar pelo envio antes de a thread de trabalho parar
+const size_t MAX_PENDING_CHUNKS = 4;
+
+// Tempo por frame gasto enviando assets para a GPU, e bytes enviados por chamada
+const double UPLOAD_BUDGET_MS = 2.0;
+const size_t UPLOAD_SLICE = 1024 * 1024;
+
+const float FIELD_OF_VIEW = 45.0f;
+// Erro de simplificacao aceito, em pixels na tela, e a fracao dele que o nivel mais
+// simples precisa ter para a troca (trocar para um nivel mais detalhado e imediato)
+const float LOD_PIXEL_ERROR = 1.0f;
+const float LOD_HYSTERESIS = 0.75f;
+
+string curvesFile = "../animations/curves.txt";
+
+// Velocidade do objeto na curva (um ponto por frame a 60 fps, como antes do passo fixo)
+const double CURVE_POINTS_PER_SECOND = 60.0;
+// Velocidade de rotacao, em radianos por segundo
+const double ROTATION_SPEED = 1.0;
+
+// Fontes das variantes do shader da cena (uma por combinacao de features dos materiais)
+const string VERTEX_SHADER = "../shaders/shaders.vs";
+const string FRAGMENT_SHADER = "../shaders/shaders.fs";
+
+// Normal apontando para fora da superficie, em [0, 255]
+const unsigned char FLAT_NORMAL[4] = { 128, 128, 255, 255 };
+const unsigned char WHITE[4] = { 255, 255, 255, 255 };
+
+bool loadGeometry(GeometryLoad& geometry, const AssetLoader& assets);
+UploadResult uploadGeometry(GeometryLoad& geometry);
+void loadMaterialLibraries(GeometryLoad& geometry);
+unsigned getMaterialFeatures(const Material* material);
+void applyMaterial(Shader& shader, const SceneUniforms& uniforms, const DrawBatch& batch);
+float stofOrElse(string value, float def);
+GLuint setupPlaceholderTexture(const unsigned char color[4]);
+bool loadTexture(TextureLoad& texture);
+UploadResult uploadTexture(TextureLoad& texture);
+vector<glm::vec3> generateControlPoints(string filename);
+
+vector<string> splitString(const string& input, char delimiter) {
+	vector<string> tokens;
+	istringstream iss(input);
+	string token;
+
+	while (getline(iss, token, delimiter)) {
+		tokens.push_back(token);
+	}
+
+	return tokens;
+}
+
+bool parseObjToVertices(const string& filename, const VertexFormat& format, vector<unsigned char>& vertices, vector<GLuint>& indices, MeshBounds& bounds,
+	MeshParts& parts) {
+	ObjLoader loader;
+
+	if (!loader.loadFileParallel(filename)) {
+		cout << "Unable to open the file: " << filename << endl;
+		return false;
+	}
+
+	MeshOptimizerStats stats;
+	loader.buildIndexed(format, vertices, indices, bounds, parts, &stats);
+
+	cout << filename << ": ACMR " << stats.before.acmr << " -> " << stats.after.acmr
+		<< ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << endl;
+
+	return true;
+}
+
+
+Scene::Scene(int width, int height, const string& objFile, const string& mtlFile)
+	: shaders(VERTEX_SHADER.c_str(), "../shaders/fallback.fs"), shader(nullptr), frameUniforms(sizeof(ObjectData)), VAO(0), placeholderVBO(0), placeholderEBO(0),
+	indicesSize(0), positionOffset(0.0f), positionScale(1.0f), rotationAxis(0.0f), height(height), nbDrawCalls(0), lodSelection(true), lod(0),
+	clusterCulling(true)
+{
+	// Ate os assets ficarem prontos, um cubo e uma textura branca ocupam o lugar deles
+	indicesSize = setupPlaceholderGeometry();
+	texID = setupPlaceholderTexture(WHITE);
+	normalTexID = setupPlaceholderTexture(FLAT_NORMAL);
+
+	// Um lote so, sem material, para o cubo inteiro. A variante dele compila em segundo
+	// plano, junto com a carga dos assets; ate ficar pronta a cena usa o programa reserva
+	DrawBatch cube = { nullptr, -1, 0, indicesSize };
+	cube.program = shaders.getVariant(VERTEX_SHADER, FRAGMENT_SHADER, cube.features);
+	drawBatches.assign(1, { cube });
+	shader = &shaders.get(cube.program);
+
+	geometry.objFile = objFile;
+	geometry.mtlFile = mtlFile;
+
+	error_code error;
+	uintmax_t objSize = filesystem::file_size(objFile, error);
+	geometry.streaming = !error && objSize >= STREAMING_THRESHOLD;
+
+	meshAsset = assets.load(objFile,
+		[this]() { return loadGeometry(geometry, assets); },
+		[this]() { return uploadGeometry(geometry); },
+		geometry.streaming);
+
+	setCamera(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, 1.0, 0.0));
+
+	// Camera e luz vao no bloco FrameData; view e cameraPos mudam a cada frame
+	projection = glm::perspective(glm::radians(FIELD_OF_VIEW), (float)width / (float)height, 0.1f, 100.0f);
+	frameUniforms.data.projection = projection;
+	frameUniforms.data.lightPos = glm::vec4(-2.0f, 10.0f, 3.0f, 1.0f);
+	frameUniforms.data.lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+	glEnable(GL_DEPTH_TEST);
+
+	vector<glm::vec3> controlPoints = generateControlPoints(curvesFile);
+
+	bezier.setControlPoints(controlPoints);
+	bezier.setShader(shader);
+	bezier.generateCurve(1500);
+
+	nbCurvePoints = bezier.getNbCurvePoints();
+	curvePosition = previousCurvePosition = 0.0;
+	angle = previousAngle = 0.0;
+}
+
+Scene::~Scene()
+{
+	// Se a malha ainda nao estava em uso, o VAO dela e outro (glDelete* ignora o 0)
+	if (geometry.VAO != VAO)
+		glDeleteVertexArrays(1, &geometry.VAO);
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &geometry.VBO);
+	glDeleteBuffers(1, &geometry.EBO);
+	glDeleteBuffers(1, &placeholderVBO);
+	glDeleteBuffers(1, &placeholderEBO);
+	glDeleteTextures(1, &texID);
+	glDeleteTextures(1, &normalTexID);
+	for (unique_ptr<TextureLoad>& texture : textures)
+		glDeleteTextures(1, &texture->texID);
+}
+
+void Scene::setCamera(glm::vec3 position, glm::vec3 front, glm::vec3 up)
+{
+	cameraPos = position;
+	cameraFront = front;
+	cameraUp = up;
+}
+
+void Scene::setupProgram(Shader& program)
+{
+	if (&program == shader)
+		return;
+
+	shader = &program;
+
+	auto found = programUniforms.find(shader);
+	if (found == programUniforms.end())
+	{
+		SceneUniforms handles;
+		handles.ka = shader->getUniform("ka");
+		handles.kd = shader->getUniform("kd");
+		handles.ks = shader->getUniform("ks");
+		handles.q = shader->getUniform("q");
+
+		shader->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+		shader->bindUniformBlock("ObjectData", OBJECT_DATA_BINDING);
+		shader->setInt("tex_buffer", 0);
+		shader->setInt("normal_buffer", 1);
+
+		found = programUniforms.emplace(shader, handles).first;
+	}
+	uniforms = found->second;
+}
+
+void Scene::update(double step)
+{
+	previousCurvePosition = curvePosition;
+	curvePosition += CURVE_POINTS_PER_SECOND * step;
+
+	// Na volta da curva o estado anterior tambem volta: a interpolacao continua do ultimo
+	// ponto para o primeiro
+	if (nbCurvePoints > 0 && curvePosition >= nbCurvePoints)
+	{
+		curvePosition -= nbCurvePoints;
+		previousCurvePosition -= nbCurvePoints;
+	}
+
+	previousAngle = angle;
+	angle += ROTATION_SPEED * step;
+
+	if (angle >= 2.0 * glm::pi<double>())
+	{
+		angle -= 2.0 * glm::pi<double>();
+		previousAngle -= 2.0 * glm::pi<double>();
+	}
+}
+
+glm::vec3 Scene::getObjectPosition(double alpha)
+{
+	if (nbCurvePoints == 0)
+		return glm::vec3(0.0f);
+
+	double position = previousCurvePosition + (curvePosition - previousCurvePosition) * alpha;
+	if (position < 0.0)
+		position += nbCurvePoints;
+
+	// Entre dois pontos da curva
+	int i = (int)position;
+	float t = (float)(position - i);
+	glm::vec3 from = bezier.getPointOnCurve(i % nbCurvePoints);
+	glm::vec3 to = bezier.getPointOnCurve((i + 1) % nbCurvePoints);
+
+	return glm::mix(from, to, t);
+}
+
+void Scene::drawFrame(double alpha)
+{
+	profiler.beginFrame();
+
+	profiler.beginScope("upload");
+	assets.update(UPLOAD_BUDGET_MS);
+	shaders.update();
+	profiler.endScope();
+
+	// Troca os placeholders pelos assets assim que estiverem na GPU
+	if (VAO != geometry.VAO && assets.isReady(meshAsset))
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &placeholderVBO);
+		glDeleteBuffers(1, &placeholderEBO);
+		placeholderVBO = placeholderEBO = 0;
+
+		VAO = geometry.VAO;
+		indicesSize = geometry.mesh.nbIndices;
+
+		geometry.vertexFormat.getDequantization(geometry.mesh.bounds, glm::value_ptr(positionOffset), glm::value_ptr(positionScale));
+
+		geometry.cache.close();
+		geometry.vertices = vector<unsigned char>();
+		geometry.indices = vector<GLuint>();
+
+		// Texturas e variantes do shader so sao pedidas agora, quando ja se sabe quais
+		// materiais a malha usa
+		setupDrawBatches();
+	}
+
+	profiler.beginScope("clear");
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	profiler.endScope();
+
+	glLineWidth(10);
+	glPointSize(20);
+
+	float rotation = (float)(previousAngle + (angle - previousAngle) * alpha);
+
+	glm::mat4 model = glm::mat4(1);
+
+	model = glm::translate(model, getObjectPosition(alpha));
+
+	if (rotationAxis != glm::vec3(0.0f))
+	{
+		model = glm::rotate(model, rotation, rotationAxis);
+	}
+
+	glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+	frameUniforms.data.view = view;
+	frameUniforms.data.cameraPos = glm::vec4(cameraPos, 1.0f);
+	frameUniforms.upload();
+
+	model = glm::scale(model, glm::vec3(0.5, 0.5, 0.5));
+
+	// Depois do FrameData, na mesma regiao do anel
+	RingBuffer& ring = frameUniforms.getRing();
+	GLintptr objectOffset = 0;
+	ObjectData* objectData = (ObjectData*)ring.allocate(sizeof(ObjectData), ring.getUniformAlignment(), objectOffset);
+	objectData->model = model;
+	objectData->positionOffset = glm::vec4(positionOffset, 0.0f);
+	objectData->positionScale = glm::vec4(positionScale, 0.0f);
+	ring.flush();
+	glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_DATA_BINDING, ring.getBuffer(), objectOffset, sizeof(ObjectData));
+
+	// O primeiro comando sempre passa pelo setupProgram, com os handles do programa dele
+	shader = nullptr;
+
+	culler.setup(projection * view, model, cameraPos);
+	const vector<Meshlet>& meshlets = geometry.mesh.parts.meshlets;
+
+	lod = lodSelection ? selectLod(model, drawBatches.size()) : 0;
+
+	// Todos os lotes estao na mesma distancia (a do objeto), ate 100 (o far da projecao)
+	float depth = glm::length(glm::vec3(model[3]) - cameraPos) / 100.0f;
+
+	renderQueue.clear();
+	nbDrawCalls = 0;
+	cullingStats = CullingStats();
+
+	for (const DrawBatch& batch : drawBatches[lod])
+	{
+		bool culled = clusterCulling && batch.nbMeshlets > 0;
+		cullingStats.nbTriangles += batch.count / 3;
+
+		if (culled)
+		{
+			clusterCounts.clear();
+			clusterOffsets.clear();
+			GLuint rangeEnd = 0;
+
+			for (GLuint i = batch.firstMeshlet; i < batch.firstMeshlet + batch.nbMeshlets; i++)
+			{
+				const Meshlet& meshlet = meshlets[i];
+				cullingStats.nbMeshlets++;
+
+				if (!culler.isVisible(meshlet))
+					continue;
+
+				cullingStats.nbMeshletsDrawn++;
+				cullingStats.nbTrianglesDrawn += meshlet.nbIndices / 3;
+
+				// Meshlets visiveis vizinhos viram uma unica faixa
+				if (!clusterCounts.empty() && rangeEnd == meshlet.firstIndex)
+					clusterCounts.back() += meshlet.nbIndices;
+				else
+				{
+					clusterCounts.push_back(meshlet.nbIndices);
+					clusterOffsets.push_back((const void*)(meshlet.firstIndex * sizeof(GLuint)));
+				}
+				rangeEnd = meshlet.firstIndex + meshlet.nbIndices;
+			}
+
+			if (clusterCounts.empty())
+				continue;
+
+			for (size_t i = 0; i < clusterCounts.size(); i++)
+				renderQueue.addRange(clusterCounts[i], clusterOffsets[i]);
+		}
+		else
+		{
+			cullingStats.nbTrianglesDrawn += batch.count / 3;
+		}
+
+		// Ate a textura do material chegar, usa a textura branca
+		GLuint batchTexture = texID;
+		if (batch.texture >= 0 && assets.isReady(textures[batch.texture]->asset))
+			batchTexture = textures[batch.texture]->texID;
+
+		DrawCommand command;
+		command.program = shaders.get(batch.program).ID;
+		command.VAO = VAO;
+		command.textures[0] = batchTexture;
+		command.indexed = indicesSize > 0;
+		command.first = batch.first;
+		command.count = batch.count;
+		command.data = &batch;
+
+		if (batch.normalTexture >= 0)
+		{
+			command.textures[1] = normalTexID;
+			if (assets.isReady(textures[batch.normalTexture]->asset))
+				command.textures[1] = textures[batch.normalTexture]->texID;
+		}
+
+		command.key = RenderQueue::makeKey(0, command.program, command.textures[0], command.VAO, depth);
+		renderQueue.submit(command);
+		nbDrawCalls++;
+	}
+
+	// Agrupados por programa e textura: o que ja estiver valendo nao e refeito
+	renderQueue.sort();
+
+	profiler.beginScope("opaque");
+	renderQueue.execute([this](const DrawCommand& command) {
+		const DrawBatch& batch = *(const DrawBatch*)command.data;
+		setupProgram(shaders.get(batch.program));
+		applyMaterial(*shader, uniforms, batch);
+	});
+	profiler.endScope();
+
+	glBindVertexArray(0);
+}
+
+int Scene::selectLod(const glm::mat4& model, int nbLods)
+{
+	const vector<MeshLod>& lods = geometry.mesh.parts.lods;
+	if (nbLods <= 1 || VAO != geometry.VAO)
+		return 0;
+
+	// Esfera envolvente da malha no mundo (o model tem escala uniforme)
+	const MeshBounds& bounds = geometry.mesh.bounds;
+	glm::vec3 boundsMin = glm::make_vec3(bounds.min), boundsMax = glm::make_vec3(bounds.max);
+	float scale = glm::length(glm::vec3(model[0]));
+	glm::vec3 center = glm::vec3(model * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+	float radius = glm::length(boundsMax - boundsMin) * 0.5f * scale;
+
+	// Ponto mais proximo da esfera (perto do plano near quando a camera esta dentro dela)
+	float distance = max(glm::length(cameraPos - center) - radius, 0.1f);
+	float pixelsPerUnit = height / (2.0f * tan(glm::radians(FIELD_OF_VIEW) * 0.5f) * distance);
+
+	auto pixelError = [&](int level) { return level == 0 ? 0.0f : lods[level - 1].error * scale * pixelsPerUnit; };
+
+	int level = min(lod, nbLods - 1);
+	while (level > 0 && pixelError(level) > LOD_PIXEL_ERROR)
+		level--;
+	while (level + 1 < nbLods && pixelError(level + 1) <= LOD_PIXEL_ERROR * LOD_HYSTERESIS)
+		level++;
+
+	return level;
+}
+
+// Features que o material usa: a variante do shader so tem essas partes. Ks 0 (ou
+// sem Ks) dispensa a parcela especular; alfa sem textura nao tem o que testar
+unsigned getMaterialFeatures(const Material* material)
+{
+	if (!material)
+		return 0;
+
+	auto has = [material](const char* key) { return material->properties.count(key) > 0; };
+	unsigned features = 0;
+
+	if (has("map_Kd"))
+		features |= FEATURE_TEXTURE;
+	if (has("Ks") && stofOrElse(material->properties.at("Ks"), 0) > 0)
+		features |= FEATURE_SPECULAR;
+	if (has("map_Bump") || has("bump") || has("norm"))
+		features |= FEATURE_NORMAL_MAP;
+	if (has("map_d") && (features & FEATURE_TEXTURE))
+		features |= FEATURE_ALPHA_TEST;
+
+	return features;
+}
+
+// Valores do material do lote para os uniforms do shader (ja convertidos no setupDrawBatches)
+void applyMaterial(Shader& shader, const SceneUniforms& uniforms, const DrawBatch& batch)
+{
+	shader.setFloat(uniforms.ka, batch.ka);
+	shader.setFloat(uniforms.kd, batch.kd);
+	shader.setFloat(uniforms.ks, batch.ks);
+	shader.setFloat(uniforms.q, batch.q);
+}
+
+GLuint setupPlaceholderTexture(const unsigned char color[4])
+{
+	GLuint texID;
+
+	glGenTextures(1, &texID);
+	glBindTexture(GL_TEXTURE_2D, texID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, color);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texID;
+}
+
+// Roda na thread de trabalho: sem chamadas GL
+bool loadTexture(TextureLoad& texture)
+{
+	texture.data = stbi_load(texture.path.c_str(), &texture.width, &texture.height, &texture.nrChannels, 0);
+
+	if (!texture.data)
+	{
+		std::cout << "Failed to load texture: " << texture.path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Envia a textura em faixas de linhas (glTexSubImage2D) de ate UPLOAD_SLICE bytes
+UploadResult uploadTexture(TextureLoad& texture)
+{
+	if (!texture.data)
+	{
+		return UPLOAD_DONE;
+	}
+
+	GLenum format = texture.nrChannels == 3 ? GL_RGB : GL_RGBA; //jpg, bmp : png
+
+	if (texture.texID == 0)
+	{
+		glGenTextures(1, &texture.texID);
+		glBindTexture(GL_TEXTURE_2D, texture.texID);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glTexImage2D(GL_TEXTURE_2D, 0, format, texture.width, texture.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, texture.texID);
+	}
+
+	size_t rowSize = (size_t)texture.width * texture.nrChannels;
+	int nbRows = min(max((int)(UPLOAD_SLICE / rowSize), 1), texture.height - texture.rowsSent);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, texture.rowsSent, texture.width, nbRows, format, GL_UNSIGNED_BYTE,
+		texture.data + texture.rowsSent * rowSize);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	texture.rowsSent += nbRows;
+
+	if (texture.rowsSent < texture.height)
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return UPLOAD_MORE;
+	}
+
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	stbi_image_free(texture.data);
+	texture.data = nullptr;
+
+	return UPLOAD_DONE;
+}
+
+
+float stofOrElse(string value, float def)
+{
+	if (value.empty())
+	{
+		return def;
+	}
+
+	try
+	{
+		return stof(value);
+	}
+	catch (const exception& e)
+	{
+		cout << "Error converting string to float: " << e.what() << endl;
+		return def;
+	}
+}
+
+
+int Scene::setupPlaceholderGeometry()
+{
+	const VertexFormat& vertexFormat = geometry.vertexFormat;
+
+	MeshBounds bounds;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		bounds.min[axis] = -0.5f;
+		bounds.max[axis] = 0.5f;
+	}
+
+	vector<unsigned char> vertices(8 * vertexFormat.getStride());
+	for (int corner = 0; corner < 8; corner++)
+	{
+		float position[3] = { corner & 1 ? 0.5f : -0.5f, corner & 2 ? 0.5f : -0.5f, corner & 4 ? 0.5f : -0.5f };
+		glm::vec3 normal = glm::normalize(glm::make_vec3(position));
+		float texCoord[2] = { 0.0f, 0.0f };
+		float color[3] = { 1.0f, 1.0f, 1.0f };
+
+		vertexFormat.writeVertex(position, color, texCoord, glm::value_ptr(normal), bounds, &vertices[corner * vertexFormat.getStride()]);
+	}
+
+	GLuint indices[36] = {
+		0, 2, 1, 1, 2, 3, // -z
+		4, 5, 6, 5, 7, 6, // +z
+		0, 1, 4, 1, 5, 4, // -y
+		2, 6, 3, 3, 6, 7, // +y
+		0, 4, 2, 2, 4, 6, // -x
+		1, 3, 5, 3, 7, 5  // +x
+	};
+
+	vertexFormat.getDequantization(bounds, glm::value_ptr(positionOffset), glm::value_ptr(positionScale));
+
+	glGenBuffers(1, &placeholderVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, placeholderVBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+	glGenVertexArrays(1, &VAO);
+	glBindVertexArray(VAO);
+
+	glGenBuffers(1, &placeholderEBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, placeholderEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	vertexFormat.setupAttributes();
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	return 36;
+}
+
+// Roda na thread de trabalho: sem chamadas GL
+bool loadGeometry(GeometryLoad& geometry, const AssetLoader& assets)
+{
+	const VertexFormat& vertexFormat = geometry.vertexFormat;
+
+	if (!geometry.streaming) {
+		if (geometry.cache.open(geometry.objFile) && geometry.cache.getMesh().vertexFormat == vertexFormat.getKey() && geometry.cache.getMesh().nbIndices > 0) {
+			geometry.mesh = geometry.cache.getMesh();
+			loadMaterialLibraries(geometry);
+			return true;
+		}
+		geometry.cache.close();
+
+		CookedMesh& mesh = geometry.mesh;
+		if (!parseObjToVertices(geometry.objFile, vertexFormat, geometry.vertices, geometry.indices, mesh.bounds, mesh.parts)) {
+			return false;
+		}
+
+		mesh.vertices = geometry.vertices.data();
+		mesh.vertexFormat = vertexFormat.getKey();
+		mesh.vertexStride = vertexFormat.getStride();
+		mesh.nbVertices = geometry.vertices.size() / vertexFormat.getStride();
+		mesh.indices = geometry.indices.data();
+		mesh.nbIndices = geometry.indices.size();
+
+		if (!geometry.indices.empty()) {
+			geometry.cache.write(geometry.objFile, mesh);
+		}
+
+		loadMaterialLibraries(geometry);
+
+		return true;
+	}
+
+	// Modelos enormes: os blocos do loader vao para a fila pending, e o render thread
+	// os envia enquanto o arquivo ainda esta sendo lido
+	auto beginUpload = [&geometry](size_t nbVertices, const MeshBounds& bounds) {
+		lock_guard<mutex> guard(geometry.lock);
+		geometry.mesh.vertexFormat = geometry.vertexFormat.getKey();
+		geometry.mesh.vertexStride = geometry.vertexFormat.getStride();
+		geometry.mesh.nbVertices = nbVertices;
+		geometry.mesh.bounds = bounds;
+		geometry.begun = true;
+	};
+
+	// Os blocos chegam em ordem: a posicao de cada um e a soma dos anteriores na fila
+	auto upload = [&geometry, &assets](const void* data, size_t, size_t size) {
+		unique_lock<mutex> guard(geometry.lock);
+
+		// Memoria limitada: espera o render thread consumir os blocos anteriores
+		while (geometry.pending.size() >= MAX_PENDING_CHUNKS && !assets.isStopping())
+			geometry.consumed.wait_for(guard, chrono::milliseconds(50));
+
+		if (!assets.isStopping())
+			geometry.pending.emplace_back((const unsigned char*)data, (const unsigned char*)data + size);
+	};
+
+	ObjLoader loader;
+	size_t nbVertices = 0;
+
+	bool ok = loader.loadFileStreaming(geometry.objFile, vertexFormat, STAGING_SIZE, beginUpload, upload, nbVertices);
+	if (!ok) {
+		cout << "Unable to open the file: " << geometry.objFile << endl;
+	}
+
+	MeshParts parts;
+	loader.buildParts(parts);
+
+	lock_guard<mutex> guard(geometry.lock);
+	geometry.mesh.nbVertices = nbVertices;
+	geometry.mesh.parts = move(parts);
+	loadMaterialLibraries(geometry);
+	geometry.finished = true;
+
+	return ok;
+}
+
+// Roda na thread de trabalho. mtlFile e lido por ultimo: em nomes repetidos, vale o dele
+void loadMaterialLibraries(GeometryLoad& geometry)
+{
+	filesystem::path folder = filesystem::path(geometry.objFile).parent_path();
+
+	for (const string& library : geometry.mesh.parts.materialLibraries) {
+		geometry.materials.loadFile((folder / library).string());
+	}
+
+	if (!geometry.materials.loadFile(geometry.mtlFile)) {
+		cout << "Unable to open the file: " << geometry.mtlFile << endl;
+	}
+}
+
+// Junta submeshes vizinhas com o mesmo material e pede o carregamento de cada textura
+// (uma vez por arquivo) e a variante do shader de cada material
+void Scene::setupDrawBatches()
+{
+	const MeshParts& parts = geometry.mesh.parts;
+	const MaterialLibrary& materials = geometry.materials;
+
+	// Sem usemtl (ou com um nome que nenhum .mtl define), vale o ultimo material de mtlFile
+	int defaultMaterial = materials.getNbMaterials() - 1;
+
+	vector<int> materialIds(parts.materialNames.size());
+	for (size_t i = 0; i < parts.materialNames.size(); i++) {
+		int id = materials.find(parts.materialNames[i]);
+		materialIds[i] = id >= 0 ? id : defaultMaterial;
+	}
+
+	// Cada textura e carregada uma vez, mesmo se varios materiais usarem
+	map<string, int> texturesByPath;
+	auto requestTexture = [this, &texturesByPath](const string& path) {
+		if (path.empty())
+			return -1;
+
+		auto found = texturesByPath.find(path);
+		if (found != texturesByPath.end())
+			return found->second;
+
+		int texture = textures.size();
+		texturesByPath[path] = texture;
+
+		TextureLoad* load = new TextureLoad();
+		load->path = path;
+		textures.emplace_back(load);
+
+		load->asset = assets.load(load->path,
+			[load]() { return loadTexture(*load); },
+			[load]() { return uploadTexture(*load); });
+
+		return texture;
+	};
+
+	auto getProperty = [](const Material* material, const string& key) {
+		if (!material)
+			return string();
+		auto found = material->properties.find(key);
+		return found != material->properties.end() ? found->second : string();
+	};
+
+	drawBatches.assign(1 + parts.lods.size(), vector<DrawBatch>());
+
+	for (size_t level = 0; level < drawBatches.size(); level++) {
+		vector<DrawBatch>& batches = drawBatches[level];
+		const Submesh* submeshes = level == 0 ? parts.submeshes.data() : &parts.lodSubmeshes[parts.lods[level - 1].firstSubmesh];
+		size_t nbSubmeshes = level == 0 ? parts.submeshes.size() : parts.lods[level - 1].nbSubmeshes;
+
+		for (size_t i = 0; i < nbSubmeshes; i++) {
+			const Submesh& submesh = submeshes[i];
+			int id = submesh.material >= 0 ? materialIds[submesh.material] : defaultMaterial;
+			const Material* material = id >= 0 ? &materials.getMaterial(id) : nullptr;
+
+			if (!batches.empty() && batches.back().material == material
+				&& batches.back().first + batches.back().count == submesh.firstIndex) {
+				batches.back().count += submesh.nbIndices;
+				continue;
+			}
+
+			DrawBatch batch = { material, requestTexture(getProperty(material, "map_Kd")), submesh.firstIndex, (GLsizei)submesh.nbIndices };
+
+			batch.ka = stofOrElse(getProperty(material, "Ka"), 0);
+			batch.kd = stofOrElse(getProperty(material, "Kd"), 1.5);
+			batch.ks = stofOrElse(getProperty(material, "Ks"), 0);
+			batch.q = stofOrElse(getProperty(material, "Ns"), 0);
+
+			batch.features = getMaterialFeatures(material);
+			batch.program = shaders.getVariant(VERTEX_SHADER, FRAGMENT_SHADER, batch.features);
+
+			if (batch.features & FEATURE_NORMAL_MAP) {
+				string normalPath = getProperty(material, "map_Bump");
+				if (normalPath.empty())
+					normalPath = getProperty(material, "bump");
+				if (normalPath.empty())
+					normalPath = getProperty(material, "norm");
+				batch.normalTexture = requestTexture(normalPath);
+			}
+
+			batches.push_back(batch);
+		}
+
+		// Cada lote fica com os meshlets da sua faixa de indices (ordenados por firstIndex)
+		for (DrawBatch& batch : batches) {
+			auto begin = lower_bound(parts.meshlets.begin(), parts.meshlets.end(), batch.first,
+				[](const Meshlet& meshlet, GLuint first) { return meshlet.firstIndex < first; });
+			auto end = lower_bound(begin, parts.meshlets.end(), batch.first + batch.count,
+				[](const Meshlet& meshlet, GLuint first) { return meshlet.firstIndex < first; });
+
+			batch.firstMeshlet = begin - parts.meshlets.begin();
+			batch.nbMeshlets = end - begin;
+		}
+	}
+
+	cout << parts.submeshes.size() << " submeshes, " << parts.materialNames.size() << " materials, "
+		<< textures.size() << " textures -> " << drawBatches[0].size() << " draw calls, " << parts.meshlets.size() << " meshlets, "
+		<< parts.lods.size() << " LODs, " << shaders.getNbPrograms() << " shader variants" << endl;
+}
+
+void createGeometryBuffers(GeometryLoad& geometry, size_t vertexDataSize, size_t indexDataSize)
+{
+	glGenVertexArrays(1, &geometry.VAO);
+	glBindVertexArray(geometry.VAO);
+
+	glGenBuffers(1, &geometry.VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, geometry.VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexDataSize, NULL, GL_STATIC_DRAW);
+
+	if (indexDataSize > 0) {
+		glGenBuffers(1, &geometry.EBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexDataSize, NULL, GL_STATIC_DRAW);
+	}
+
+	geometry.vertexFormat.setupAttributes();
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+// Roda no render thread: envia no maximo UPLOAD_SLICE bytes por chamada
+UploadResult uploadGeometry(GeometryLoad& geometry)
+{
+	if (geometry.streaming) {
+		vector<unsigned char> chunk;
+		{
+			lock_guard<mutex> guard(geometry.lock);
+
+			if (!geometry.begun) {
+				return UPLOAD_WAIT;
+			}
+			if (geometry.VAO == 0) {
+				createGeometryBuffers(geometry, geometry.mesh.getVertexDataSize(), 0);
+			}
+			if (geometry.pending.empty()) {
+				return geometry.finished ? UPLOAD_DONE : UPLOAD_WAIT;
+			}
+
+			chunk = move(geometry.pending.front());
+			geometry.pending.pop_front();
+		}
+		geometry.consumed.notify_one();
+
+		glBindBuffer(GL_ARRAY_BUFFER, geometry.VBO);
+		glBufferSubData(GL_ARRAY_BUFFER, geometry.vertexBytesSent, chunk.size(), chunk.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		geometry.vertexBytesSent += chunk.size();
+
+		return UPLOAD_MORE;
+	}
+
+	const CookedMesh& mesh = geometry.mesh;
+
+	if (geometry.VAO == 0) {
+		createGeometryBuffers(geometry, mesh.getVertexDataSize(), mesh.getIndexDataSize());
+	}
+
+	if (geometry.vertexBytesSent < mesh.getVertexDataSize()) {
+		size_t size = min(UPLOAD_SLICE, mesh.getVertexDataSize() - geometry.vertexBytesSent);
+
+		glBindBuffer(GL_ARRAY_BUFFER, geometry.VBO);
+		glBufferSubData(GL_ARRAY_BUFFER, geometry.vertexBytesSent, size, (const unsigned char*)mesh.vertices + geometry.vertexBytesSent);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		geometry.vertexBytesSent += size;
+	}
+	else if (geometry.indexBytesSent < mesh.getIndexDataSize()) {
+		size_t size = min(UPLOAD_SLICE, mesh.getIndexDataSize() - geometry.indexBytesSent);
+
+		// O EBO faz parte do estado do VAO
+		glBindVertexArray(geometry.VAO);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, geometry.indexBytesSent, size, (const unsigned char*)mesh.indices + geometry.indexBytesSent);
+		glBindVertexArray(0);
+		geometry.indexBytesSent += size;
+	}
+
+	bool done = geometry.vertexBytesSent == mesh.getVertexDataSize() && geometry.indexBytesSent == mesh.getIndexDataSize();
+
+	return done ? UPLOAD_DONE : UPLOAD_MORE;
+}
+
+
+vector<glm::vec3> generateControlPoints(string filename)
+{
+	ifstream file(filename);
+	vector<glm::vec3> points;
+
+	if (file.is_open()) {
+		string line;
+
+		while (getline(file, line)) {
+			vector<string> row = splitString(line, ',');
+
+			if (row.empty()) {
+				continue;
+			}
+
+			glm::vec3 point;
+			point.x = stofOrElse(row[0], 0.0f);
+			point.y = stofOrElse(row[1], 0.0f);
+			point.z = stofOrElse(row[2], 0.0f);
+
+			points.push_back(point);
+		}
+
+		file.close();
+	}
+	else {
+		cout << "Unable to open the file: " << filename << endl;
+	}
+
+	return points;
+}
@@ -0,0 +1,28 @@
+#version 450
+
+// Programa reserva do ShaderManager, usado enquanto o shaders.fs compila: so a
+// textura com uma luz difusa, sem material (pequeno para compilar rapido)
+in vec3 scaledNormal;
+in vec2 texCoord;
+in vec3 fragPos;
+
+layout(std140) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 cameraPos;
+	vec4 lightPos;
+	vec4 lightColor;
+};
+
+uniform sampler2D tex_buffer;
+
+out vec4 color;
+
+void main()
+{
+	vec3 L = normalize(lightPos.xyz - fragPos);
+	float diff = max(dot(normalize(scaledNormal), L), 0.0) * 0.8 + 0.2;
+
+	color = vec4(diff * texture(tex_buffer, texCoord).rgb * lightColor.rgb, 1.0);
+}
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
 
 //GLAD
 #include <glad/glad.h>
@@ -16,6 +19,19 @@
 
 using namespace std;
 
+// Uniform ativo do programa, lido uma vez depois do link, com o ultimo valor enviado
+struct ShaderUniform
+{
+	string name;
+	GLenum type;     // GL_FLOAT_VEC3, GL_FLOAT_MAT4, GL_SAMPLER_2D...
+	GLint location;
+	GLfloat value[16]; // ints e bools guardados pelos bits
+	bool hasValue;
+};
+
+// Indice na tabela de uniforms do Shader (-1 = nao existe ou foi eliminado pelo compilador)
+typedef int UniformHandle;
+
 class Shader
 {
 public:
@@ -95,6 +111,7 @@ public:
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
 
+		reflectUniforms();
 	}
 	// Uses the current shader
 	void Use()
@@ -102,34 +119,146 @@ public:
 		glUseProgram(this->ID);
 	}
 
-	void setBool(const std::string& name, bool value) const
+	// Handle de um uniform, para usar nos set* sem procurar pelo nome a cada frame
+	UniformHandle getUniform(const std::string& name) const
+	{
+		// Poucos uniforms por programa: a busca linear basta
+		for (size_t i = 0; i < uniforms.size(); i++)
+		{
+			if (uniforms[i].name == name)
+				return (UniformHandle)i;
+		}
+		return -1;
+	}
+
+	// Os set* so chamam glUniform* quando o valor muda. Como antes, valem para o
+	// programa em uso (glUseProgram(ID)); quem chamar glUniform* direto deve chamar
+	// resetUniforms() depois.
+	void setBool(UniformHandle uniform, bool value)
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+		setInt(uniform, (int)value);
 	}
 	// ------------------------------------------------------------------------
-	void setInt(const std::string& name, int value) const
+	void setInt(UniformHandle uniform, int value)
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+		if (update(uniform, &value, sizeof(value), GL_INT))
+			glUniform1i(uniforms[uniform].location, value);
 	}
 	// ------------------------------------------------------------------------
-	void setFloat(const std::string& name, float value) const
+	void setFloat(UniformHandle uniform, float value)
 	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+		if (update(uniform, &value, sizeof(value), GL_FLOAT))
+			glUniform1f(uniforms[uniform].location, value);
 	}
 	// ------------------------------------------------------------------------
-	void setVec3(const std::string& name, float v1, float v2, float v3) const
+	void setVec3(UniformHandle uniform, float v1, float v2, float v3)
+	{
+		GLfloat value[3] = { v1, v2, v3 };
+		if (update(uniform, value, sizeof(value), GL_FLOAT_VEC3))
+			glUniform3fv(uniforms[uniform].location, 1, value);
+	}
+
+	void setVec4(UniformHandle uniform, float v1, float v2, float v3, float v4)
+	{
+		GLfloat value[4] = { v1, v2, v3, v4 };
+		if (update(uniform, value, sizeof(value), GL_FLOAT_VEC4))
+			glUniform4fv(uniforms[uniform].location, 1, value);
+	}
+
+	void setMat4(UniformHandle uniform, const float* v)
 	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+		if (update(uniform, v, 16 * sizeof(GLfloat), GL_FLOAT_MAT4))
+			glUniformMatrix4fv(uniforms[uniform].location, 1, GL_FALSE, v);
 	}
 
-	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
+	// Versoes pelo nome, para a configuracao inicial (sem glGetUniformLocation)
+	void setBool(const std::string& name, bool value) { setBool(getUniform(name), value); }
+	void setInt(const std::string& name, int value) { setInt(getUniform(name), value); }
+	void setFloat(const std::string& name, float value) { setFloat(getUniform(name), value); }
+	void setVec3(const std::string& name, float v1, float v2, float v3) { setVec3(getUniform(name), v1, v2, v3); }
+	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) { setVec4(getUniform(name), v1, v2, v3, v4); }
+	void setMat4(const std::string& name, const float* v) { setMat4(getUniform(name), v); }
+
+	// Esquece os valores guardados: o proximo set* de cada uniform sempre envia
+	void resetUniforms()
 	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		for (ShaderUniform& uniform : uniforms)
+			uniform.hasValue = false;
 	}
 
-	void setMat4(const std::string& name, float *v) const
+	const vector<ShaderUniform>& getUniforms() const { return uniforms; }
+
+	// Liga o bloco de uniforms name ao ponto de ligacao binding (false se o programa nao
+	// usa o bloco)
+	bool bindUniformBlock(const std::string& name, GLuint binding)
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+		if (index == GL_INVALID_INDEX)
+			return false;
+
+		glUniformBlockBinding(ID, index, binding);
+		return true;
+	}
+
+protected:
+	vector<ShaderUniform> uniforms;
+
+	// Tabela com os uniforms ativos (os que o compilador nao eliminou)
+	void reflectUniforms()
+	{
+		GLint nbUniforms = 0, maxLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &nbUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+		vector<GLchar> name(max(maxLength, 1));
+
+		for (GLint i = 0; i < nbUniforms; i++)
+		{
+			GLint size;
+			GLenum type;
+			glGetActiveUniform(ID, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+
+			ShaderUniform uniform;
+			uniform.name = name.data();
+			uniform.type = type;
+			uniform.location = glGetUniformLocation(ID, name.data());
+			uniform.hasValue = false;
+
+			// Uniforms em blocos nao tem localizacao
+			if (uniform.location < 0)
+				continue;
+
+			// Arrays aparecem como "nome[0]": os set* enviam so o primeiro elemento
+			size_t bracket = uniform.name.find('[');
+			if (bracket != string::npos)
+				uniform.name.resize(bracket);
+
+			uniforms.push_back(uniform);
+		}
+	}
+
+	// Confere o tipo e guarda o valor; false quando nao ha nada a enviar
+	bool update(UniformHandle handle, const void* value, size_t size, GLenum type)
+	{
+		if (handle < 0 || handle >= (int)uniforms.size())
+			return false;
+
+		ShaderUniform& uniform = uniforms[handle];
+
+		// Samplers e bools sao enviados com glUniform1i
+		bool intLike = uniform.type == GL_INT || uniform.type == GL_BOOL || uniform.type == GL_SAMPLER_2D || uniform.type == GL_SAMPLER_CUBE;
+		if (uniform.type != type && !(type == GL_INT && intLike))
+		{
+			std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << uniform.name << std::endl;
+			return false;
+		}
+
+		if (uniform.hasValue && memcmp(uniform.value, value, size) == 0)
+			return false;
+
+		memcpy(uniform.value, value, size);
+		uniform.hasValue = true;
+		return true;
 	}
 };
 
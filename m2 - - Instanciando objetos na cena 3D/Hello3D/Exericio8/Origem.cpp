@@ -1,6 +1,7 @@
 ﻿
 #include <iostream>
 #include <string>
+#include <vector>
 #include <assert.h>
 
 using namespace std;
@@ -19,6 +20,8 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 int setupShader();
 int setupGeometry();
+GLuint setupInstances(GLuint VAO);
+GLsizei uploadInstances(GLuint instanceVBO, bool grid);
 
 
 const GLuint WIDTH = 1000, HEIGHT = 1000;
@@ -26,11 +29,12 @@ const GLuint WIDTH = 1000, HEIGHT = 1000;
 const GLchar* vertexShaderSource = "#version 450\n"
 "layout (location = 0) in vec3 position;\n"
 "layout (location = 1) in vec3 color;\n"
+"layout (location = 2) in vec4 instance;\n"
 "uniform mat4 model;\n"
 "out vec4 finalColor;\n"
 "void main()\n"
 "{\n"
-"gl_Position = model * vec4(position, 1.0);\n"
+"gl_Position = model * vec4(position * instance.w + instance.xyz, 1.0);\n"
 "finalColor = vec4(color, 1.0);\n"
 "}\0";
 const GLchar* fragmentShaderSource = "#version 450\n"
@@ -46,6 +50,11 @@ bool translateX = false, translateY = false, translateZ = false;
 
 float scaleFactor = 1.0f;
 
+// Copias dos cubos numa unica chamada de desenho: cada instancia tem deslocamento (xyz)
+// e escala (w) proprios. A tecla I troca entre uma instancia e a grade
+const int INSTANCE_GRID = 10;
+bool showGrid = false, gridChanged = false;
+
 int main()
 {
 	glfwInit();
@@ -74,6 +83,8 @@ int main()
 	GLuint shaderID = setupShader();
 
 	GLuint VAO = setupGeometry();
+	GLuint instanceVBO = setupInstances(VAO);
+	GLsizei nInstances = uploadInstances(instanceVBO, showGrid);
 
 
 	glUseProgram(shaderID);
@@ -82,7 +93,7 @@ int main()
 	GLint modelLoc = glGetUniformLocation(shaderID, "model");
 	
 	model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	glUniformMatrix4fv(modelLoc, 1, FALSE, glm::value_ptr(model));
+	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 
 
 	while (!glfwWindowShouldClose(window))
@@ -134,19 +145,26 @@ int main()
 		model = model * scaleMatrix;
 
 
-		glUniformMatrix4fv(modelLoc, 1, FALSE, glm::value_ptr(model));
+		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 		
+		if (gridChanged)
+		{
+			nInstances = uploadInstances(instanceVBO, showGrid);
+			gridChanged = false;
+		}
+
 		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36 * 2);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36 * 2, nInstances);
 
 
-		glDrawArrays(GL_POINTS, 0, 36 * 2);
+		glDrawArraysInstanced(GL_POINTS, 0, 36 * 2, nInstances);
 		glBindVertexArray(0);
 
 		glfwSwapBuffers(window);
 	}
 	
 	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &instanceVBO);
 	
 	glfwTerminate();
 	return 0;
@@ -210,6 +228,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		translateZ = true;
 	}
 
+	if (key == GLFW_KEY_I && action == GLFW_PRESS)
+	{
+		showGrid = !showGrid;
+		gridChanged = true;
+	}
+
 
 
 }
@@ -411,3 +435,48 @@ int setupGeometry()
 	return VAO;
 }
 
+GLuint setupInstances(GLuint VAO)
+{
+	GLuint instanceVBO;
+	glGenBuffers(1, &instanceVBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+	// Divisor 1: o atributo avanca uma vez por instancia, nao por vertice
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(2);
+	glVertexAttribDivisor(2, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	return instanceVBO;
+}
+
+GLsizei uploadInstances(GLuint instanceVBO, bool grid)
+{
+	vector<glm::vec4> instances;
+
+	if (!grid)
+	{
+		instances.push_back(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+	else
+	{
+		float spacing = 2.0f / INSTANCE_GRID;
+		for (int y = 0; y < INSTANCE_GRID; y++)
+		{
+			for (int x = 0; x < INSTANCE_GRID; x++)
+			{
+				instances.push_back(glm::vec4(-1.0f + (x + 0.5f) * spacing, -1.0f + (y + 0.5f) * spacing, 0.0f, spacing * 0.4f));
+			}
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec4), instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return (GLsizei)instances.size();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+// Arquivo mapeado em memoria (somente leitura). Usa mmap no Linux e
+// CreateFileMapping/MapViewOfFile no Windows.
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const string& filename);
+	void close();
+	bool isOpen() const { return data != nullptr; }
+	const char* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+protected:
+	const char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+#include "MeshParts.h"
+#include "VertexFormat.h"
+
+using namespace std;
+
+// Cabecalho do arquivo de malha "cozida". Os dados de vertices (e indices,
+// quando houver) vem logo depois, nos offsets indicados, prontos para o glBufferData.
+// Depois deles ficam as submeshes, os meshlets, os niveis de detalhe e as submeshes
+// deles, e os nomes (objetos, materiais e mtllib, nessa ordem), cada um terminado em '\0'.
+struct MeshCacheHeader
+{
+	char magic[4];          // "MSHC"
+	uint32_t version;
+	uint64_t sourcePathHash; // FNV-1a do caminho do .obj
+	uint64_t sourceSize;     // tamanho do .obj quando o cache foi gerado
+	int64_t sourceTime;      // data de modificacao do .obj quando o cache foi gerado
+	uint32_t vertexFormat;   // VertexFormat::getKey()
+	uint32_t vertexStride;   // bytes por vertice
+	uint32_t nbVertices;
+	uint32_t nbIndices;      // 0 = malha nao indexada (indices sempre uint32)
+	float boundsMin[3];
+	float boundsMax[3];
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint32_t nbSubmeshes;
+	uint32_t nbObjectNames;
+	uint32_t nbMaterialNames;
+	uint32_t nbMaterialLibraries;
+	uint32_t nbMeshlets;
+	uint32_t nbLods;
+	uint32_t nbLodSubmeshes;
+	uint64_t submeshOffset;
+	uint64_t meshletOffset;
+	uint64_t lodOffset;
+	uint64_t lodSubmeshOffset;
+	uint64_t stringsOffset;
+	uint64_t stringsSize;
+};
+
+// Malha pronta para o glBufferData: usada tanto para gravar quanto para ler o cache
+struct CookedMesh
+{
+	const void* vertices = nullptr;
+	uint32_t vertexFormat = 0;
+	uint32_t vertexStride = 0;
+	uint32_t nbVertices = 0;
+	const uint32_t* indices = nullptr;
+	uint32_t nbIndices = 0;
+	MeshBounds bounds;
+	MeshParts parts;
+
+	size_t getVertexDataSize() const { return (size_t)vertexStride * nbVertices; }
+	size_t getIndexDataSize() const { return sizeof(uint32_t) * nbIndices; }
+};
+
+// Cache binario de malhas lidas de OBJ. Na primeira carga o resultado do parser
+// e gravado em cacheDir; nas seguintes o arquivo e apenas mapeado em memoria,
+// desde que o .obj de origem nao tenha mudado (mesmo caminho, tamanho e data).
+class MeshCache
+{
+public:
+	static const uint32_t VERSION = 8;
+
+	MeshCache(const string& cacheDir = "../cache/") : cacheDir(cacheDir) {}
+
+	// Mapeia o cache de sourcePath; retorna false se nao existir ou estiver desatualizado
+	bool open(const string& sourcePath);
+	void close();
+
+	bool write(const string& sourcePath, const CookedMesh& mesh);
+
+	// Dados mapeados; validos ate o close()
+	const CookedMesh& getMesh() const { return mesh; }
+
+	string getCachePath(const string& sourcePath) const;
+
+protected:
+	string cacheDir;
+	MappedFile file;
+	CookedMesh mesh;
+};
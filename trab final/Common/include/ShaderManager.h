@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+using namespace std;
+
+// Indice de um programa no ShaderManager
+typedef int ProgramHandle;
+
+// Features de material que viram "#define FEATURE_..." nos shaders: cada combinacao e
+// uma variante, sem o custo (nem os samplers) do que o material nao usa
+enum ShaderFeature
+{
+	FEATURE_TEXTURE = 1 << 0,    // map_Kd
+	FEATURE_SPECULAR = 1 << 1,   // Ks > 0
+	FEATURE_NORMAL_MAP = 1 << 2, // map_Bump / bump / norm
+	FEATURE_ALPHA_TEST = 1 << 3, // map_d (so junto com FEATURE_TEXTURE)
+};
+
+// Linhas "#define" das features ligadas
+string getFeatureDefines(unsigned features);
+
+// Programas criados sem travar o frame. add() so manda compilar e linkar; update(),
+// uma vez por frame, termina os que ja ficaram prontos. Ate la get() devolve o programa
+// reserva, que e compilado (pequeno) no construtor.
+//
+// Com GL_KHR_parallel_shader_compile o driver compila todos ao mesmo tempo em outras
+// threads e update() nunca espera. Sem a extensao o driver compila na hora (ou na
+// primeira consulta do status): update() termina um programa por frame, para dividir
+// a espera entre os frames.
+class ShaderManager
+{
+public:
+	// Precisa do loadGLExtensions ja chamado
+	ShaderManager(const GLchar* fallbackVertexPath, const GLchar* fallbackFragmentPath);
+
+	ProgramHandle add(const GLchar* vertexPath, const GLchar* fragmentPath, const string& defines = "");
+	// Variante com as features: so e compilada no primeiro pedido, os seguintes devolvem
+	// o mesmo programa
+	ProgramHandle getVariant(const string& vertexPath, const string& fragmentPath, unsigned features);
+
+	void update();
+	// Termina todos, esperando o que faltar
+	void finishAll();
+
+	// O programa, ou o reserva enquanto ele nao estiver pronto (ou se o link falhou)
+	Shader& get(ProgramHandle program);
+	bool isReady(ProgramHandle program) const;
+	// Nenhum programa pendente
+	bool isIdle() const { return nbPending == 0; }
+	int getNbPrograms() const { return (int)programs.size(); }
+
+	static bool hasParallelCompile() { return GLAD_GL_KHR_parallel_shader_compile != 0; }
+
+protected:
+	unique_ptr<Shader> fallback;
+	vector<unique_ptr<Shader>> programs;
+	vector<bool> linked;
+	// Variantes ja pedidas: "vs|fs|features" -> programa
+	map<string, ProgramHandle> variants;
+	int nbPending = 0;
+
+	void finish(ProgramHandle program);
+};
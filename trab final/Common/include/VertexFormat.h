@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// Localizacao de cada atributo no vertex shader (layout (location = N))
+enum VertexAttribute
+{
+	POSITION_ATTRIB = 0,
+	COLOR_ATTRIB = 1,
+	TEXCOORD_ATTRIB = 2,
+	NORMAL_ATTRIB = 3,
+	NB_VERTEX_ATTRIBS = 4
+};
+
+// Como cada atributo e gravado no VBO
+enum AttributeEncoding
+{
+	ENCODING_NONE = 0,        // atributo descartado
+	ENCODING_FLOAT,           // 32 bits por componente
+	ENCODING_HALF,            // 16 bits por componente (GL_HALF_FLOAT)
+	ENCODING_SNORM16,         // 16 bits normalizados em [-1, 1] (posicao relativa a AABB)
+	ENCODING_SNORM_2_10_10_10 // GL_INT_2_10_10_10_REV normalizado (normais)
+};
+
+// Caixa envolvente da malha; usada para quantizar posicoes
+struct MeshBounds
+{
+	float min[3] = { 0.0f, 0.0f, 0.0f };
+	float max[3] = { 0.0f, 0.0f, 0.0f };
+
+	void getCenter(float center[3]) const;
+	// Metade do tamanho da caixa em cada eixo (nunca zero)
+	void getHalfExtent(float halfExtent[3]) const;
+};
+
+// Descreve o layout intercalado de um vertice. E o mesmo descritor que o loader usa
+// para gravar os vertices, que o setupAttributes usa para montar o VAO e que define
+// os uniforms positionOffset/positionScale lidos pelo vertex shader.
+class VertexFormat
+{
+public:
+	VertexFormat(AttributeEncoding position = ENCODING_FLOAT, AttributeEncoding color = ENCODING_FLOAT,
+		AttributeEncoding texCoord = ENCODING_FLOAT, AttributeEncoding normal = ENCODING_FLOAT);
+
+	// 11 floats (44 bytes): o layout original dos exercicios
+	static VertexFormat full();
+	// Posicao snorm16, sem cor, st em half float e normal 2_10_10_10 (16 bytes)
+	static VertexFormat compact();
+
+	bool has(VertexAttribute attribute) const { return encodings[attribute] != ENCODING_NONE; }
+	AttributeEncoding getEncoding(VertexAttribute attribute) const { return encodings[attribute]; }
+	int getOffset(VertexAttribute attribute) const { return offsets[attribute]; }
+	int getStride() const { return stride; }
+	// Identificador do formato (gravado no cache de malhas)
+	uint32_t getKey() const;
+
+	// Configura os glVertexAttribPointer do VAO e VBO vinculados
+	void setupAttributes() const;
+
+	// Grava um vertice em out (getStride() bytes). color/texCoord/normal podem ser nulos
+	void writeVertex(const float* position, const float* color, const float* texCoord, const float* normal,
+		const MeshBounds& bounds, unsigned char* out) const;
+
+	// Valores de positionOffset/positionScale para o shader: posicao = lida * scale + offset
+	void getDequantization(const MeshBounds& bounds, float offset[3], float scale[3]) const;
+
+protected:
+	AttributeEncoding encodings[NB_VERTEX_ATTRIBS];
+	int offsets[NB_VERTEX_ATTRIBS];
+	int stride;
+};
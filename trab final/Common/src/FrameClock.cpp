@@ -0,0 +1,74 @@
+#include "FrameClock.h"
+
+#include <algorithm>
+#include <thread>
+
+// O sleep do sistema pode acordar atrasado: a ultima parte da espera e ativa
+const double SPIN_TIME = 0.002;
+
+FrameClock::FrameClock(double step) : step(step)
+{
+	reset();
+}
+
+void FrameClock::reset()
+{
+	accumulator = 0.0;
+	lastTick = nextFrame = Clock::now();
+}
+
+int FrameClock::tick()
+{
+	Clock::time_point now = Clock::now();
+	double elapsed = chrono::duration<double>(now - lastTick).count();
+	lastTick = now;
+
+	return advance(elapsed);
+}
+
+int FrameClock::advance(double frameTime)
+{
+	this->frameTime = frameTime;
+	nbFrames++;
+
+	accumulator += min(frameTime, MAX_FRAME_TIME);
+
+	int steps = 0;
+	while (accumulator >= step)
+	{
+		accumulator -= step;
+		simulationTime += step;
+		steps++;
+	}
+	nbSteps += steps;
+
+	return steps;
+}
+
+void FrameClock::limitFrame()
+{
+	if (frameLimit <= 0.0)
+		return;
+
+	Clock::duration period = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / frameLimit));
+	Clock::time_point now = Clock::now();
+
+	// Atrasado: comeca o proximo frame ja, sem tentar recuperar o tempo perdido
+	nextFrame += period;
+	if (nextFrame <= now)
+	{
+		nextFrame = now;
+		return;
+	}
+
+	Clock::time_point wake = nextFrame - chrono::duration_cast<Clock::duration>(chrono::duration<double>(SPIN_TIME));
+	if (wake > now)
+		this_thread::sleep_until(wake);
+	while (Clock::now() < nextFrame)
+		;
+}
+
+double FrameClock::now()
+{
+	return chrono::duration<double>(Clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,388 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+static const unsigned int UNUSED = 0xFFFFFFFFu;
+
+// Cache FIFO por carimbo de tempo: o vertice esta no cache se entrou ha no maximo
+// cacheSize insercoes. Somar cacheSize + 1 a time esvazia o cache.
+// Retorna quantos dos 3 vertices do triangulo faltaram.
+static int updateCache(const unsigned int* triangle, vector<unsigned int>& timestamps, unsigned int& time, int cacheSize)
+{
+	int misses = 0;
+
+	for (int k = 0; k < 3; k++)
+	{
+		unsigned int vertex = triangle[k];
+		if (time - timestamps[vertex] > (unsigned int)cacheSize)
+		{
+			timestamps[vertex] = time++;
+			misses++;
+		}
+	}
+
+	return misses;
+}
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t nbIndices, size_t nbVertices, int cacheSize)
+{
+	VertexCacheStats stats;
+	size_t nbTriangles = nbIndices / 3;
+	if (nbTriangles == 0)
+		return stats;
+
+	vector<unsigned int> timestamps(nbVertices, 0);
+	vector<bool> used(nbVertices, false);
+	unsigned int time = cacheSize + 1;
+	size_t nbUsed = 0;
+
+	for (size_t t = 0; t < nbTriangles; t++)
+	{
+		stats.nbTransformed += updateCache(&indices[t * 3], timestamps, time, cacheSize);
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (!used[indices[t * 3 + k]])
+			{
+				used[indices[t * 3 + k]] = true;
+				nbUsed++;
+			}
+		}
+	}
+
+	stats.acmr = (float)stats.nbTransformed / nbTriangles;
+	stats.atvr = (float)stats.nbTransformed / nbUsed;
+
+	return stats;
+}
+
+void optimizeVertexCache(unsigned int* indices, size_t nbIndices, size_t nbVertices, int cacheSize)
+{
+	size_t nbTriangles = nbIndices / 3;
+	if (nbTriangles == 0)
+		return;
+
+	// Triangulos de cada vertice: adjacency[offsets[v], offsets[v + 1])
+	vector<unsigned int> offsets(nbVertices + 1, 0);
+	for (size_t i = 0; i < nbTriangles * 3; i++)
+		offsets[indices[i] + 1]++;
+	partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	vector<unsigned int> adjacency(nbTriangles * 3);
+	vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < nbTriangles * 3; i++)
+		adjacency[fill[indices[i]]++] = i / 3;
+
+	// Triangulos ainda nao emitidos de cada vertice
+	vector<unsigned int> liveTriangles(nbVertices);
+	for (size_t v = 0; v < nbVertices; v++)
+		liveTriangles[v] = offsets[v + 1] - offsets[v];
+
+	vector<unsigned int> timestamps(nbVertices, 0);
+	vector<bool> emitted(nbTriangles, false);
+	vector<unsigned int> deadEnds;
+	vector<unsigned int> candidates;
+	vector<unsigned int> output;
+	output.reserve(nbTriangles * 3);
+
+	unsigned int time = cacheSize + 1;
+	size_t cursor = 0;
+	int fan = indices[0];
+
+	while (fan >= 0)
+	{
+		// Emite todos os triangulos restantes em volta do vertice atual (um leque)
+		candidates.clear();
+
+		for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; a++)
+		{
+			unsigned int triangle = adjacency[a];
+			if (emitted[triangle])
+				continue;
+
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int vertex = indices[triangle * 3 + k];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if (time - timestamps[vertex] > (unsigned int)cacheSize)
+					timestamps[vertex] = time++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// Proximo leque: o vertice vizinho que continua no cache mesmo depois de emitir
+		// os seus triangulos (cada um pode inserir ate 2 vertices); entre eles, o mais antigo
+		int next = -1;
+		int bestPriority = -1;
+
+		for (unsigned int vertex : candidates)
+		{
+			if (liveTriangles[vertex] == 0)
+				continue;
+
+			unsigned int age = time - timestamps[vertex];
+			int priority = age + 2 * liveTriangles[vertex] <= (unsigned int)cacheSize ? (int)age : 0;
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		// Beco sem saida: volta para um vertice recente com triangulos, senao o proximo em ordem
+		while (next < 0 && !deadEnds.empty())
+		{
+			unsigned int vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[vertex] > 0)
+				next = vertex;
+		}
+
+		while (next < 0 && cursor < nbVertices)
+		{
+			if (liveTriangles[cursor] > 0)
+				next = cursor;
+			cursor++;
+		}
+
+		fan = next;
+	}
+
+	copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(unsigned int* indices, size_t nbIndices, const float* positions, size_t positionStride, size_t nbVertices,
+	float threshold, int cacheSize)
+{
+	size_t nbTriangles = nbIndices / 3;
+	if (nbTriangles == 0)
+		return;
+
+	auto position = [positions, positionStride](unsigned int vertex) {
+		return (const float*)((const unsigned char*)positions + vertex * positionStride);
+	};
+
+	vector<unsigned int> timestamps(nbVertices, 0);
+	unsigned int time = cacheSize + 1;
+
+	// Limites fortes: um triangulo com as 3 faltas comeca uma regiao nova da malha
+	vector<size_t> regions;
+	for (size_t t = 0; t < nbTriangles; t++)
+	{
+		if (updateCache(&indices[t * 3], timestamps, time, cacheSize) == 3 || t == 0)
+			regions.push_back(t);
+	}
+
+	// Limites suaves: dentro de cada regiao, fecha um grupo assim que o ACMR acumulado
+	// chega a threshold x o ACMR da regiao inteira
+	vector<size_t> clusters;
+	for (size_t r = 0; r < regions.size(); r++)
+	{
+		size_t start = regions[r];
+		size_t end = r + 1 < regions.size() ? regions[r + 1] : nbTriangles;
+
+		time += cacheSize + 1;
+		int regionMisses = 0;
+		for (size_t t = start; t < end; t++)
+			regionMisses += updateCache(&indices[t * 3], timestamps, time, cacheSize);
+
+		float target = threshold * regionMisses / (end - start);
+
+		clusters.push_back(start);
+		time += cacheSize + 1;
+		int misses = 0, faces = 0;
+
+		for (size_t t = start; t < end; t++)
+		{
+			misses += updateCache(&indices[t * 3], timestamps, time, cacheSize);
+			faces++;
+
+			if ((float)misses / faces <= target)
+			{
+				clusters.push_back(t + 1);
+				time += cacheSize + 1;
+				misses = faces = 0;
+			}
+		}
+
+		// O ultimo grupo da regiao nunca chega ao alvo: junta com o anterior
+		if (clusters.back() != start)
+			clusters.pop_back();
+	}
+
+	// Centro da malha
+	float center[3] = { 0.0f, 0.0f, 0.0f };
+	for (size_t i = 0; i < nbTriangles * 3; i++)
+	{
+		const float* p = position(indices[i]);
+		for (int axis = 0; axis < 3; axis++)
+			center[axis] += p[axis] / (nbTriangles * 3);
+	}
+
+	// Cada grupo: centro e normal ponderados pela area; quanto mais o grupo aponta para
+	// fora do centro da malha, mais cedo ele e desenhado
+	vector<float> sortKeys(clusters.size());
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : nbTriangles;
+		float centroid[3] = { 0.0f, 0.0f, 0.0f };
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		float area = 0.0f;
+
+		for (size_t t = clusters[c]; t < end; t++)
+		{
+			const float* p0 = position(indices[t * 3]);
+			const float* p1 = position(indices[t * 3 + 1]);
+			const float* p2 = position(indices[t * 3 + 2]);
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float triangleArea = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				centroid[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * triangleArea;
+				normal[axis] += n[axis];
+			}
+			area += triangleArea;
+		}
+
+		float length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0.0f;
+
+		if (area > 0.0f && length > 0.0f)
+		{
+			for (int axis = 0; axis < 3; axis++)
+				key += (centroid[axis] / area - center[axis]) * normal[axis] / length;
+		}
+
+		sortKeys[c] = key;
+	}
+
+	vector<size_t> order(clusters.size());
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	vector<unsigned int> output;
+	output.reserve(nbTriangles * 3);
+
+	for (size_t c : order)
+	{
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : nbTriangles;
+		output.insert(output.end(), indices + clusters[c] * 3, indices + end * 3);
+	}
+
+	copy(output.begin(), output.end(), indices);
+}
+
+// Novo id de cada vertice: ordem do primeiro uso pelos indices (que ja sao reescritos),
+// vertices nao usados no fim. Retorna quantos sao usados.
+static size_t buildFetchRemap(unsigned int* indices, size_t nbIndices, size_t nbVertices, vector<unsigned int>& remap)
+{
+	remap.assign(nbVertices, UNUSED);
+	unsigned int nbUsed = 0;
+
+	for (size_t i = 0; i < nbIndices; i++)
+	{
+		unsigned int& vertex = remap[indices[i]];
+		if (vertex == UNUSED)
+			vertex = nbUsed++;
+		indices[i] = vertex;
+	}
+
+	unsigned int next = nbUsed;
+	for (size_t v = 0; v < nbVertices; v++)
+	{
+		if (remap[v] == UNUSED)
+			remap[v] = next++;
+	}
+
+	return nbUsed;
+}
+
+static void remapVertices(void* vertices, size_t nbVertices, size_t stride, const vector<unsigned int>& remap)
+{
+	vector<unsigned char> original((unsigned char*)vertices, (unsigned char*)vertices + nbVertices * stride);
+	for (size_t v = 0; v < nbVertices; v++)
+		memcpy((unsigned char*)vertices + remap[v] * stride, &original[v * stride], stride);
+}
+
+size_t optimizeVertexFetch(void* vertices, size_t nbVertices, size_t stride, unsigned int* indices, size_t nbIndices)
+{
+	vector<unsigned int> remap;
+	size_t nbUsed = buildFetchRemap(indices, nbIndices, nbVertices, remap);
+	remapVertices(vertices, nbVertices, stride, remap);
+
+	return nbUsed;
+}
+
+size_t optimizeMesh(void* vertices, size_t nbVertices, size_t stride, unsigned int* indices, size_t nbIndices,
+	const vector<IndexRange>& ranges, float* positions, size_t positionStride, MeshOptimizerStats& stats)
+{
+	stats.before = analyzeVertexCache(indices, nbIndices, nbVertices);
+
+	vector<IndexRange> allRanges = ranges;
+	if (allRanges.empty())
+		allRanges.push_back({ 0, nbIndices });
+
+	// Cada faixa usa ids locais: os algoritmos alocam por vertice, e uma submesh
+	// costuma usar so uma parte dos vertices da malha
+	vector<unsigned int> globalToLocal(nbVertices, UNUSED);
+	vector<unsigned int> localToGlobal;
+	vector<unsigned int> localIndices;
+	vector<float> localPositions;
+
+	for (const IndexRange& range : allRanges)
+	{
+		localToGlobal.clear();
+		localPositions.clear();
+		localIndices.resize(range.count);
+
+		for (size_t i = 0; i < range.count; i++)
+		{
+			unsigned int vertex = indices[range.first + i];
+			if (globalToLocal[vertex] == UNUSED)
+			{
+				globalToLocal[vertex] = localToGlobal.size();
+				localToGlobal.push_back(vertex);
+
+				const float* p = (const float*)((const unsigned char*)positions + vertex * positionStride);
+				localPositions.insert(localPositions.end(), p, p + 3);
+			}
+			localIndices[i] = globalToLocal[vertex];
+		}
+
+		optimizeVertexCache(localIndices.data(), range.count, localToGlobal.size());
+		optimizeOverdraw(localIndices.data(), range.count, localPositions.data(), 3 * sizeof(float), localToGlobal.size());
+
+		for (size_t i = 0; i < range.count; i++)
+			indices[range.first + i] = localToGlobal[localIndices[i]];
+
+		for (unsigned int vertex : localToGlobal)
+			globalToLocal[vertex] = UNUSED;
+	}
+
+	vector<unsigned int> remap;
+	size_t nbUsed = buildFetchRemap(indices, nbIndices, nbVertices, remap);
+	remapVertices(vertices, nbVertices, stride, remap);
+
+	// Posicoes num array separado acompanham a nova ordem dos vertices
+	const unsigned char* vertexData = (const unsigned char*)vertices;
+	const unsigned char* positionData = (const unsigned char*)positions;
+	if (positionData < vertexData || positionData >= vertexData + nbVertices * stride)
+		remapVertices(positions, nbVertices, positionStride, remap);
+
+	stats.after = analyzeVertexCache(indices, nbIndices, nbUsed);
+
+	return nbUsed;
+}
@@ -0,0 +1,834 @@
+#include "ObjLoader.h"
+
+#include <charconv>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+// Cor fixa gravada em cada vertice (atributo 1 do VAO)
+static const float DEFAULT_COLOR[3] = { 0.4f, 0.1f, 0.4f };
+
+static inline const char* skipSpaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t'))
+		++p;
+	return p;
+}
+
+static inline const char* skipLine(const char* p, const char* end)
+{
+	while (p < end && *p != '\n')
+		++p;
+	return p < end ? p + 1 : p;
+}
+
+static inline const char* parseFloat(const char* p, const char* end, float& value)
+{
+	p = skipSpaces(p, end);
+	if (p < end && *p == '+')
+		++p;
+
+	from_chars_result result = from_chars(p, end, value);
+	if (result.ec != errc())
+	{
+		value = 0.0f;
+		return p;
+	}
+	return result.ptr;
+}
+
+static inline const char* parseInt(const char* p, const char* end, int& value)
+{
+	if (p < end && *p == '+')
+		++p;
+
+	from_chars_result result = from_chars(p, end, value);
+	if (result.ec != errc())
+	{
+		value = 0;
+		return p;
+	}
+	return result.ptr;
+}
+
+// Le o resto da linha (sem os espacos das pontas) em name
+static inline const char* parseName(const char* p, const char* end, string& name)
+{
+	p = skipSpaces(p, end);
+
+	const char* start = p;
+	while (p < end && *p != '\n' && *p != '\r')
+		++p;
+
+	const char* last = p;
+	while (last > start && (last[-1] == ' ' || last[-1] == '\t'))
+		--last;
+
+	name.assign(start, last);
+	return p;
+}
+
+// Testa se a linha em p comeca com a palavra-chave keyword seguida de espaco
+static inline bool isKeyword(const char* p, const char* end, const char* keyword, size_t length)
+{
+	return (size_t)(end - p) > length && memcmp(p, keyword, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+}
+
+// Converte um indice do OBJ (base 1, ou negativo relativo ao fim da lista) para base 0
+static inline int resolveIndex(int index, int count)
+{
+	if (index > 0)
+		return index - 1;
+	if (index < 0)
+		return count + index;
+	return -1;
+}
+
+void ObjMesh::computeBounds(MeshBounds& bounds) const
+{
+	if (positions.empty())
+	{
+		bounds = MeshBounds();
+		return;
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		bounds.min[axis] = positions[axis];
+		bounds.max[axis] = positions[axis];
+	}
+
+	for (size_t i = 0; i < positions.size(); i += 3)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bounds.min[axis] = min(bounds.min[axis], positions[i + axis]);
+			bounds.max[axis] = max(bounds.max[axis], positions[i + axis]);
+		}
+	}
+}
+
+void ObjMesh::clear()
+{
+	positions.clear();
+	texCoords.clear();
+	normals.clear();
+	corners.clear();
+	groups.clear();
+	materialLibraries.clear();
+	nbTriangles = 0;
+}
+
+bool ObjLoader::readFile(const string& filename)
+{
+	ifstream file(filename, ios::binary | ios::ate);
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	streamsize size = file.tellg();
+	file.seekg(0, ios::beg);
+
+	fileBuffer.resize(size);
+	if (size > 0 && !file.read(fileBuffer.data(), size))
+	{
+		return false;
+	}
+
+	file.close();
+
+	return true;
+}
+
+bool ObjLoader::loadFile(const string& filename)
+{
+	if (!readFile(filename))
+	{
+		return false;
+	}
+
+	parse(fileBuffer.data(), fileBuffer.data() + fileBuffer.size());
+
+	return true;
+}
+
+bool ObjLoader::loadFileParallel(const string& filename, int nbThreads)
+{
+	if (!readFile(filename))
+	{
+		return false;
+	}
+
+	parseParallel(fileBuffer.data(), fileBuffer.data() + fileBuffer.size(), nbThreads);
+
+	return true;
+}
+
+// Le as linhas v/vt/vn/f de [p, end): v/vt/vn vao para as listas de mesh e cada
+// triangulo e entregue a emitTriangle(cantos[3], relativos[3]). Indices negativos
+// sao resolvidos contra as listas de mesh; relativos[i] marca (bits 0/1/2 = v/vt/vn)
+// quais indices do canto i eram negativos.
+template <class TriangleSink>
+static void parseRange(const char* p, const char* end, ObjMesh& mesh, TriangleSink& emitTriangle)
+{
+	while (p < end)
+	{
+		p = skipSpaces(p, end);
+
+		if (p + 1 < end && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			float x, y, z;
+			p = parseFloat(p + 1, end, x);
+			p = parseFloat(p, end, y);
+			p = parseFloat(p, end, z);
+
+			mesh.positions.push_back(x);
+			mesh.positions.push_back(y);
+			mesh.positions.push_back(z);
+		}
+		else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+		{
+			float s, t;
+			p = parseFloat(p + 2, end, s);
+			p = parseFloat(p, end, t);
+
+			mesh.texCoords.push_back(s);
+			mesh.texCoords.push_back(t);
+		}
+		else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+		{
+			float nx, ny, nz;
+			p = parseFloat(p + 2, end, nx);
+			p = parseFloat(p, end, ny);
+			p = parseFloat(p, end, nz);
+
+			mesh.normals.push_back(nx);
+			mesh.normals.push_back(ny);
+			mesh.normals.push_back(nz);
+		}
+		else if (isKeyword(p, end, "o", 1) || isKeyword(p, end, "g", 1) || isKeyword(p, end, "usemtl", 6))
+		{
+			ObjGroup group;
+			group.firstTriangle = mesh.nbTriangles;
+			group.setsObject = p[0] != 'u';
+			group.setsMaterial = !group.setsObject;
+
+			p = parseName(p + (group.setsObject ? 1 : 6), end, group.name);
+			mesh.groups.push_back(move(group));
+		}
+		else if (isKeyword(p, end, "mtllib", 6))
+		{
+			// Pode listar varios arquivos
+			p = skipSpaces(p + 6, end);
+			while (p < end && *p != '\n' && *p != '\r')
+			{
+				const char* start = p;
+				while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+					++p;
+				mesh.materialLibraries.emplace_back(start, p);
+				p = skipSpaces(p, end);
+			}
+		}
+		else if (p + 1 < end && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			int nbPositions = mesh.getNbPositions();
+			int nbTexCoords = mesh.getNbTexCoords();
+			int nbNormals = mesh.getNbNormals();
+
+			ObjIndex first, previous;
+			int firstRelative = 0, previousRelative = 0;
+			int nbCorners = 0;
+
+			p = skipSpaces(p + 1, end);
+
+			// Cada canto e "v", "v/vt", "v//vn" ou "v/vt/vn"; poligonos viram leques de triangulos
+			while (p < end && *p != '\n' && *p != '\r' && *p != '#')
+			{
+				int v = 0, t = 0, n = 0;
+
+				const char* start = p;
+				p = parseInt(p, end, v);
+				if (p < end && *p == '/')
+				{
+					++p;
+					if (p < end && *p != '/')
+						p = parseInt(p, end, t);
+					if (p < end && *p == '/')
+						p = parseInt(p + 1, end, n);
+				}
+
+				if (p == start)
+					break;
+
+				ObjIndex corner;
+				corner.v = resolveIndex(v, nbPositions);
+				corner.t = resolveIndex(t, nbTexCoords);
+				corner.n = resolveIndex(n, nbNormals);
+
+				// Bits 0/1/2: v/vt/vn vieram negativos (relativos)
+				int relative = (v < 0 ? 1 : 0) | (t < 0 ? 2 : 0) | (n < 0 ? 4 : 0);
+
+				if (nbCorners == 0)
+				{
+					first = corner;
+					firstRelative = relative;
+				}
+				else if (nbCorners >= 2)
+				{
+					ObjIndex triangle[3] = { first, previous, corner };
+					int masks[3] = { firstRelative, previousRelative, relative };
+					emitTriangle(triangle, masks);
+					mesh.nbTriangles++;
+				}
+
+				previous = corner;
+				previousRelative = relative;
+				nbCorners++;
+
+				p = skipSpaces(p, end);
+			}
+		}
+
+		p = skipLine(p, end);
+	}
+}
+
+// Guarda o triangulo em mesh.corners; se fixups for informado, os cantos com indices
+// relativos sao anotados para que o parseParallel possa desloca-los depois.
+static inline void storeTriangle(ObjMesh& mesh, vector<ObjFixup>* fixups, const ObjIndex* triangle, const int* relative)
+{
+	mesh.corners.push_back(triangle[0]);
+	mesh.corners.push_back(triangle[1]);
+	mesh.corners.push_back(triangle[2]);
+
+	if (fixups && (relative[0] | relative[1] | relative[2]))
+	{
+		int base = mesh.corners.size() - 3;
+		for (int i = 0; i < 3; i++)
+			for (int attribute = 0; attribute < 3; attribute++)
+				if (relative[i] & (1 << attribute))
+					fixups->push_back({ base + i, attribute });
+	}
+}
+
+void ObjLoader::parse(const char* begin, const char* end)
+{
+	mesh.clear();
+
+	auto store = [this](const ObjIndex* triangle, const int* relative) {
+		storeTriangle(mesh, nullptr, triangle, relative);
+	};
+	parseRange(begin, end, mesh, store);
+}
+
+void ObjLoader::parseParallel(const char* begin, const char* end, int nbThreads)
+{
+	mesh.clear();
+
+	if (nbThreads <= 0)
+	{
+		nbThreads = thread::hardware_concurrency();
+	}
+
+	size_t size = end - begin;
+	int nbChunks = min<size_t>(max(nbThreads, 1), max<size_t>(size / MIN_CHUNK_SIZE, 1));
+
+	if (nbChunks == 1)
+	{
+		parse(begin, end);
+		return;
+	}
+
+	// 1. Divide o arquivo em blocos de tamanho parecido, sempre terminando em '\n'
+	vector<const char*> bounds(nbChunks + 1);
+	bounds[0] = begin;
+	bounds[nbChunks] = end;
+
+	for (int i = 1; i < nbChunks; i++)
+	{
+		const char* p = max(begin + size * i / nbChunks, bounds[i - 1]);
+		while (p < end && *p != '\n')
+			++p;
+		bounds[i] = p < end ? p + 1 : end;
+	}
+
+	chunks.resize(nbChunks);
+	chunkFixups.resize(nbChunks);
+
+	// 2. Cada thread le o seu bloco de forma independente
+	vector<thread> workers;
+	for (int i = 0; i < nbChunks; i++)
+	{
+		workers.emplace_back([this, &bounds, i]() {
+			chunks[i].clear();
+			chunkFixups[i].clear();
+
+			auto store = [this, i](const ObjIndex* triangle, const int* relative) {
+				storeTriangle(chunks[i], &chunkFixups[i], triangle, relative);
+			};
+			parseRange(bounds[i], bounds[i + 1], chunks[i], store);
+		});
+	}
+	for (thread& worker : workers)
+		worker.join();
+	workers.clear();
+
+	// 3. Soma de prefixos: onde cada bloco comeca nas listas finais
+	vector<ObjIndex> listOffsets(nbChunks + 1);
+	vector<size_t> cornerOffsets(nbChunks + 1);
+	listOffsets[0] = { 0, 0, 0 };
+	cornerOffsets[0] = 0;
+
+	for (int i = 0; i < nbChunks; i++)
+	{
+		listOffsets[i + 1].v = listOffsets[i].v + chunks[i].getNbPositions();
+		listOffsets[i + 1].t = listOffsets[i].t + chunks[i].getNbTexCoords();
+		listOffsets[i + 1].n = listOffsets[i].n + chunks[i].getNbNormals();
+		cornerOffsets[i + 1] = cornerOffsets[i] + chunks[i].corners.size();
+	}
+
+	mesh.positions.resize(listOffsets[nbChunks].v * 3);
+	mesh.texCoords.resize(listOffsets[nbChunks].t * 2);
+	mesh.normals.resize(listOffsets[nbChunks].n * 3);
+	mesh.corners.resize(cornerOffsets[nbChunks]);
+
+	// Grupos e mtllib sao poucos: juntados aqui mesmo, deslocando o primeiro triangulo
+	for (int i = 0; i < nbChunks; i++)
+	{
+		int triangleOffset = cornerOffsets[i] / 3;
+		for (ObjGroup& group : chunks[i].groups)
+		{
+			group.firstTriangle += triangleOffset;
+			mesh.groups.push_back(move(group));
+		}
+		for (string& library : chunks[i].materialLibraries)
+			mesh.materialLibraries.push_back(move(library));
+	}
+	mesh.nbTriangles = cornerOffsets[nbChunks] / 3;
+
+	// 4. Junta os blocos em paralelo; indices relativos sao deslocados pelo inicio do bloco
+	for (int i = 0; i < nbChunks; i++)
+	{
+		workers.emplace_back([this, &listOffsets, &cornerOffsets, i]() {
+			const ObjMesh& chunk = chunks[i];
+			copy(chunk.positions.begin(), chunk.positions.end(), mesh.positions.begin() + listOffsets[i].v * 3);
+			copy(chunk.texCoords.begin(), chunk.texCoords.end(), mesh.texCoords.begin() + listOffsets[i].t * 2);
+			copy(chunk.normals.begin(), chunk.normals.end(), mesh.normals.begin() + listOffsets[i].n * 3);
+
+			ObjIndex* corners = &mesh.corners[cornerOffsets[i]];
+			copy(chunk.corners.begin(), chunk.corners.end(), corners);
+
+			for (const ObjFixup& fixup : chunkFixups[i])
+			{
+				ObjIndex& corner = corners[fixup.corner];
+				if (fixup.attribute == 0)
+					corner.v += listOffsets[i].v;
+				else if (fixup.attribute == 1)
+					corner.t += listOffsets[i].t;
+				else
+					corner.n += listOffsets[i].n;
+			}
+		});
+	}
+	for (thread& worker : workers)
+		worker.join();
+}
+
+// Escreve os 11 floats (pos, cor, st, normal) de um canto de face em out
+static inline void writeVertex(const ObjMesh& mesh, const ObjIndex& corner, float* out)
+{
+	if (corner.v >= 0 && corner.v < mesh.getNbPositions())
+	{
+		const float* position = &mesh.positions[corner.v * 3];
+		out[0] = position[0];
+		out[1] = position[1];
+		out[2] = position[2];
+	}
+	else
+	{
+		out[0] = out[1] = out[2] = 0.0f;
+	}
+
+	out[3] = DEFAULT_COLOR[0];
+	out[4] = DEFAULT_COLOR[1];
+	out[5] = DEFAULT_COLOR[2];
+
+	if (corner.t >= 0 && corner.t < mesh.getNbTexCoords())
+	{
+		const float* texCoord = &mesh.texCoords[corner.t * 2];
+		out[6] = texCoord[0];
+		out[7] = texCoord[1];
+	}
+	else
+	{
+		out[6] = out[7] = 0.0f;
+	}
+
+	if (corner.n >= 0 && corner.n < mesh.getNbNormals())
+	{
+		const float* normal = &mesh.normals[corner.n * 3];
+		out[8] = normal[0];
+		out[9] = normal[1];
+		out[10] = normal[2];
+	}
+	else
+	{
+		out[8] = out[9] = out[10] = 0.0f;
+	}
+}
+
+void ObjLoader::buildInterleaved(vector<float>& buffer) const
+{
+	buffer.resize(mesh.corners.size() * FLOATS_PER_VERTEX);
+
+	float* out = buffer.data();
+
+	for (const ObjIndex& corner : mesh.corners)
+	{
+		writeVertex(mesh, corner, out);
+		out += FLOATS_PER_VERTEX;
+	}
+}
+
+// Trecho de triangulos seguidos com o mesmo objeto e material
+struct ObjRun
+{
+	int firstTriangle;
+	int nbTriangles;
+	int object;
+	int material;
+};
+
+// Aplica os grupos (o/g/usemtl) em ordem, dando ids aos nomes em parts
+static void resolveGroups(const ObjMesh& mesh, vector<ObjRun>& runs, MeshParts& parts)
+{
+	parts.clear();
+	parts.materialLibraries = mesh.materialLibraries;
+
+	unordered_map<string, int> objectIds, materialIds;
+	int object = -1, material = -1;
+	int first = 0;
+
+	auto closeRun = [&](int end) {
+		if (end <= first)
+			return;
+
+		if (!runs.empty() && runs.back().object == object && runs.back().material == material)
+			runs.back().nbTriangles += end - first;
+		else
+			runs.push_back({ first, end - first, object, material });
+
+		first = end;
+	};
+
+	for (const ObjGroup& group : mesh.groups)
+	{
+		closeRun(group.firstTriangle);
+
+		unordered_map<string, int>& ids = group.setsObject ? objectIds : materialIds;
+		vector<string>& names = group.setsObject ? parts.objectNames : parts.materialNames;
+
+		auto found = ids.find(group.name);
+		int id = found != ids.end() ? found->second : (int)names.size();
+		if (found == ids.end())
+		{
+			ids[group.name] = id;
+			names.push_back(group.name);
+		}
+
+		if (group.setsObject)
+			object = id;
+		else
+			material = id;
+	}
+
+	closeRun(mesh.nbTriangles);
+}
+
+void ObjLoader::buildParts(MeshParts& parts) const
+{
+	vector<ObjRun> runs;
+	resolveGroups(mesh, runs, parts);
+
+	for (const ObjRun& run : runs)
+		parts.submeshes.push_back({ (uint32_t)run.firstTriangle * 3, (uint32_t)run.nbTriangles * 3, run.object, run.material });
+}
+
+void ObjLoader::buildIndexed(const VertexFormat& format, vector<unsigned char>& vertices, vector<unsigned int>& indices, MeshBounds& bounds,
+	MeshParts& parts, MeshOptimizerStats* stats, bool cook) const
+{
+	size_t nbCorners = mesh.corners.size();
+
+	// Trechos ordenados por material (estavel): cada material vira uma faixa continua de indices
+	vector<ObjRun> runs;
+	resolveGroups(mesh, runs, parts);
+
+	vector<int> order(runs.size());
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&runs](int a, int b) { return runs[a].material < runs[b].material; });
+
+	// Tabela hash de enderecamento aberto: triplas v/vt/vn -> indice do vertice unico
+	size_t capacity = 16;
+	while (capacity < nbCorners * 2)
+		capacity <<= 1;
+
+	const unsigned int EMPTY = 0xFFFFFFFFu;
+	vector<unsigned int> slots(capacity, EMPTY);
+	vector<ObjIndex> uniqueCorners;
+	uniqueCorners.reserve(nbCorners / 2);
+
+	indices.resize(nbCorners);
+	size_t nbIndices = 0;
+
+	for (int runIndex : order)
+	{
+		const ObjRun& run = runs[runIndex];
+		parts.submeshes.push_back({ (uint32_t)nbIndices, (uint32_t)run.nbTriangles * 3, run.object, run.material });
+
+		for (size_t i = run.firstTriangle * 3; i < (size_t)(run.firstTriangle + run.nbTriangles) * 3; i++)
+		{
+			const ObjIndex& corner = mesh.corners[i];
+
+			size_t slot = ((unsigned int)corner.v * 73856093u ^ (unsigned int)corner.t * 19349663u ^ (unsigned int)corner.n * 83492791u) & (capacity - 1);
+
+			while (slots[slot] != EMPTY)
+			{
+				const ObjIndex& other = uniqueCorners[slots[slot]];
+				if (other.v == corner.v && other.t == corner.t && other.n == corner.n)
+					break;
+				slot = (slot + 1) & (capacity - 1);
+			}
+
+			if (slots[slot] == EMPTY)
+			{
+				slots[slot] = uniqueCorners.size();
+				uniqueCorners.push_back(corner);
+			}
+
+			indices[nbIndices++] = slots[slot];
+		}
+	}
+
+	mesh.computeBounds(bounds);
+
+	int stride = format.getStride();
+	vertices.resize(uniqueCorners.size() * stride);
+
+	unsigned char* out = vertices.data();
+	float vertex[FLOATS_PER_VERTEX];
+	// Posicoes em float, antes da quantizacao, para os LODs, a otimizacao de overdraw e os
+	// meshlets; st e normal para os LODs escolherem a variante de cada canto nas costuras
+	vector<float> positions(cook ? uniqueCorners.size() * 3 : 0);
+	vector<float> attributes(cook ? uniqueCorners.size() * 5 : 0);
+
+	for (size_t i = 0; i < uniqueCorners.size(); i++)
+	{
+		writeVertex(mesh, uniqueCorners[i], vertex);
+		format.writeVertex(&vertex[0], &vertex[3], &vertex[6], &vertex[8], bounds, out);
+		if (cook)
+		{
+			copy(vertex, vertex + 3, &positions[i * 3]);
+			copy(vertex + 6, vertex + 11, &attributes[i * 5]);
+		}
+		out += stride;
+	}
+
+	if (!cook)
+		return;
+
+	buildLods(indices, parts, positions.data(), 3 * sizeof(float), attributes.data(), 5, uniqueCorners.size());
+
+	// Os niveis de detalhe vem depois do nivel 0 no index buffer, cada submesh numa faixa
+	vector<IndexRange> ranges;
+	for (const Submesh& submesh : parts.submeshes)
+		ranges.push_back({ submesh.firstIndex, submesh.nbIndices });
+	for (const Submesh& submesh : parts.lodSubmeshes)
+		ranges.push_back({ submesh.firstIndex, submesh.nbIndices });
+
+	MeshOptimizerStats optimizerStats;
+	optimizeMesh(vertices.data(), uniqueCorners.size(), stride, indices.data(), indices.size(), ranges,
+		positions.data(), 3 * sizeof(float), stats ? *stats : optimizerStats);
+
+	buildMeshlets(indices.data(), indices.size(), ranges, positions.data(), 3 * sizeof(float), uniqueCorners.size(), parts.meshlets);
+}
+
+// Totais da primeira passada do loadFileStreaming
+struct ObjCounts
+{
+	size_t nbPositions = 0;
+	size_t nbTexCoords = 0;
+	size_t nbNormals = 0;
+	size_t nbCorners = 0;
+	MeshBounds bounds;
+};
+
+// Conta as linhas v/vt/vn e os cantos de triangulos de [p, end), sem guardar nada
+// alem da AABB das posicoes
+static void countRange(const char* p, const char* end, ObjCounts& counts)
+{
+	while (p < end)
+	{
+		p = skipSpaces(p, end);
+
+		if (p + 1 < end && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			float position[3];
+			p = parseFloat(p + 1, end, position[0]);
+			p = parseFloat(p, end, position[1]);
+			p = parseFloat(p, end, position[2]);
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (counts.nbPositions == 0 || position[axis] < counts.bounds.min[axis])
+					counts.bounds.min[axis] = position[axis];
+				if (counts.nbPositions == 0 || position[axis] > counts.bounds.max[axis])
+					counts.bounds.max[axis] = position[axis];
+			}
+			counts.nbPositions++;
+		}
+		else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+		{
+			counts.nbTexCoords++;
+		}
+		else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+		{
+			counts.nbNormals++;
+		}
+		else if (p + 1 < end && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			int nbCorners = 0;
+
+			p = skipSpaces(p + 1, end);
+			while (p < end && *p != '\n' && *p != '\r' && *p != '#')
+			{
+				while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' && *p != '#')
+					++p;
+				nbCorners++;
+				p = skipSpaces(p, end);
+			}
+
+			if (nbCorners >= 3)
+				counts.nbCorners += 3 * (nbCorners - 2);
+		}
+
+		p = skipLine(p, end);
+	}
+}
+
+// Le o arquivo em blocos de block.size() bytes e entrega a parseBlock apenas linhas
+// completas; o pedaco de linha do fim de um bloco vai para o inicio do proximo
+static bool forEachBlock(ifstream& file, vector<char>& block, const function<void(const char*, const char*)>& parseBlock)
+{
+	file.clear();
+	file.seekg(0, ios::beg);
+
+	size_t pending = 0;
+
+	while (true)
+	{
+		file.read(block.data() + pending, block.size() - pending);
+		size_t size = pending + (size_t)file.gcount();
+
+		const char* begin = block.data();
+		const char* end = begin + size;
+		const char* linesEnd = end;
+
+		if (!file.eof())
+		{
+			while (linesEnd > begin && linesEnd[-1] != '\n')
+				--linesEnd;
+
+			// Linha maior que o bloco: e cortada
+			if (linesEnd == begin)
+				linesEnd = end;
+		}
+
+		parseBlock(begin, linesEnd);
+
+		pending = end - linesEnd;
+		memmove(block.data(), linesEnd, pending);
+
+		if (file.eof())
+			break;
+		if (!file)
+			return false;
+	}
+
+	return true;
+}
+
+bool ObjLoader::loadFileStreaming(const string& filename, const VertexFormat& format, size_t stagingSize,
+	const function<void(size_t nbVertices, const MeshBounds& bounds)>& beginUpload,
+	const function<void(const void* data, size_t offset, size_t size)>& upload,
+	size_t& nbVertices)
+{
+	nbVertices = 0;
+
+	ifstream file(filename, ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	vector<char> block(STREAM_BLOCK_SIZE);
+
+	// 1. Primeira passada: totais e AABB
+	ObjCounts counts;
+	if (!forEachBlock(file, block, [&counts](const char* begin, const char* end) { countRange(begin, end, counts); }))
+	{
+		return false;
+	}
+
+	// Reserva exata: evita que o push_back dobre a capacidade no fim de uma lista enorme
+	mesh.clear();
+	mesh.positions.reserve(counts.nbPositions * 3);
+	mesh.texCoords.reserve(counts.nbTexCoords * 2);
+	mesh.normals.reserve(counts.nbNormals * 3);
+
+	beginUpload(counts.nbCorners, counts.bounds);
+
+	// 2. Segunda passada: cada triangulo vai direto para o buffer de staging
+	size_t stride = format.getStride();
+	size_t triangleSize = 3 * stride;
+	vector<unsigned char> staging(max(stagingSize / triangleSize, (size_t)1) * triangleSize);
+
+	size_t used = 0;
+	size_t uploaded = 0;
+	float vertex[FLOATS_PER_VERTEX];
+
+	auto flush = [&]() {
+		if (used > 0)
+		{
+			upload(staging.data(), uploaded, used);
+			uploaded += used;
+			used = 0;
+		}
+	};
+
+	auto emit = [&](const ObjIndex* triangle, const int*) {
+		// Nunca passa do que a primeira passada contou (o VBO ja foi alocado)
+		if (nbVertices + 3 > counts.nbCorners)
+			return;
+
+		for (int i = 0; i < 3; i++)
+		{
+			writeVertex(mesh, triangle[i], vertex);
+			format.writeVertex(&vertex[0], &vertex[3], &vertex[6], &vertex[8], counts.bounds, &staging[used]);
+			used += stride;
+		}
+		nbVertices += 3;
+
+		if (used == staging.size())
+			flush();
+	};
+
+	bool ok = forEachBlock(file, block, [this, &emit](const char* begin, const char* end) { parseRange(begin, end, mesh, emit); });
+	flush();
+
+	return ok;
+}
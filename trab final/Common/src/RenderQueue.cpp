@@ -0,0 +1,152 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+uint64_t RenderQueue::makeKey(unsigned pass, unsigned program, unsigned material, unsigned VAO, float depth)
+{
+	auto field = [](uint64_t value, int bits) { return value & ((1ull << bits) - 1); };
+
+	uint64_t quantizedDepth = (uint64_t)(min(max(depth, 0.0f), 1.0f) * ((1 << DEPTH_BITS) - 1));
+
+	uint64_t key = field(pass, PASS_BITS);
+	key = key << PROGRAM_BITS | field(program, PROGRAM_BITS);
+	key = key << MATERIAL_BITS | field(material, MATERIAL_BITS);
+	key = key << VAO_BITS | field(VAO, VAO_BITS);
+	key = key << DEPTH_BITS | quantizedDepth;
+	return key;
+}
+
+void RenderQueue::clear()
+{
+	commands.clear();
+	order.clear();
+	rangeCounts.clear();
+	rangeOffsets.clear();
+	pendingRange = 0;
+}
+
+void RenderQueue::addRange(GLsizei count, const void* offset)
+{
+	rangeCounts.push_back(count);
+	rangeOffsets.push_back(offset);
+}
+
+void RenderQueue::submit(const DrawCommand& command)
+{
+	commands.push_back(command);
+	commands.back().firstRange = pendingRange;
+	commands.back().nbRanges = getNbPendingRanges();
+	pendingRange = (uint32_t)rangeCounts.size();
+}
+
+void RenderQueue::dropPendingRanges()
+{
+	rangeCounts.resize(pendingRange);
+	rangeOffsets.resize(pendingRange);
+}
+
+void RenderQueue::sort()
+{
+	size_t n = commands.size();
+	order.resize(n);
+	orderTemp.resize(n);
+	for (size_t i = 0; i < n; i++)
+		order[i] = (uint32_t)i;
+
+	if (n < 2)
+		return;
+
+	// Histogramas dos 8 bytes numa leitura so das chaves
+	vector<uint32_t> histograms(8 * 256, 0);
+	for (const DrawCommand& command : commands)
+	{
+		for (int b = 0; b < 8; b++)
+			histograms[b * 256 + ((command.key >> (b * 8)) & 0xFF)]++;
+	}
+
+	for (int b = 0; b < 8; b++)
+	{
+		uint32_t* histogram = &histograms[b * 256];
+
+		// Todos com o mesmo byte: a passada nao mudaria a ordem
+		if (histogram[(commands[0].key >> (b * 8)) & 0xFF] == n)
+			continue;
+
+		uint32_t offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			uint32_t count = histogram[digit];
+			histogram[digit] = offset;
+			offset += count;
+		}
+
+		// Estavel: comandos com a mesma chave ficam na ordem em que foram submetidos
+		for (uint32_t index : order)
+			orderTemp[histogram[(commands[index].key >> (b * 8)) & 0xFF]++] = index;
+		order.swap(orderTemp);
+	}
+}
+
+void RenderQueue::execute(const function<void(const DrawCommand&)>& setup)
+{
+	stats = RenderQueueStats();
+
+	// 0 = desconhecido (os comandos nunca usam o programa, VAO ou textura 0)
+	GLuint program = 0, VAO = 0;
+	GLuint textures[RENDER_TEXTURE_UNITS] = {};
+	int activeUnit = -1;
+
+	for (uint32_t index : order)
+	{
+		const DrawCommand& command = commands[index];
+		stats.nbCommands++;
+		stats.nbRequested += 2;
+
+		if (command.program != program)
+		{
+			glUseProgram(command.program);
+			program = command.program;
+			stats.programChanges++;
+		}
+
+		for (int unit = 0; unit < RENDER_TEXTURE_UNITS; unit++)
+		{
+			if (command.textures[unit] == 0)
+				continue;
+			stats.nbRequested++;
+
+			if (command.textures[unit] == textures[unit])
+				continue;
+
+			if (activeUnit != unit)
+			{
+				glActiveTexture(GL_TEXTURE0 + unit);
+				activeUnit = unit;
+			}
+			glBindTexture(GL_TEXTURE_2D, command.textures[unit]);
+			textures[unit] = command.textures[unit];
+			stats.textureChanges++;
+		}
+
+		if (command.VAO != VAO)
+		{
+			glBindVertexArray(command.VAO);
+			VAO = command.VAO;
+			stats.vaoChanges++;
+		}
+
+		if (setup)
+			setup(command);
+
+		if (command.nbRanges > 0)
+			glMultiDrawElements(command.mode, &rangeCounts[command.firstRange], GL_UNSIGNED_INT, &rangeOffsets[command.firstRange], command.nbRanges);
+		else if (command.indexed)
+			glDrawElements(command.mode, command.count, GL_UNSIGNED_INT, (const void*)(command.first * sizeof(GLuint)));
+		else
+			glDrawArrays(command.mode, command.first, command.count);
+	}
+
+	// Quem desenha depois da fila espera a unidade 0 ativa
+	if (activeUnit > 0)
+		glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,180 @@
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+using namespace std;
+
+// Componentes de cada atributo: posicao xyz, cor rgb, st, normal xyz
+static const int NB_COMPONENTS[NB_VERTEX_ATTRIBS] = { 3, 3, 2, 3 };
+
+// Bytes ocupados por um atributo, arredondado para multiplo de 4 (alinhamento do VBO)
+static int getAttributeSize(AttributeEncoding encoding, int nbComponents)
+{
+	switch (encoding)
+	{
+	case ENCODING_FLOAT:
+		return 4 * nbComponents;
+	case ENCODING_HALF:
+	case ENCODING_SNORM16:
+		return (2 * nbComponents + 3) & ~3;
+	case ENCODING_SNORM_2_10_10_10:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+void MeshBounds::getCenter(float center[3]) const
+{
+	for (int i = 0; i < 3; i++)
+		center[i] = (min[i] + max[i]) * 0.5f;
+}
+
+void MeshBounds::getHalfExtent(float halfExtent[3]) const
+{
+	for (int i = 0; i < 3; i++)
+		halfExtent[i] = std::max((max[i] - min[i]) * 0.5f, 1e-6f);
+}
+
+VertexFormat::VertexFormat(AttributeEncoding position, AttributeEncoding color, AttributeEncoding texCoord, AttributeEncoding normal)
+{
+	encodings[POSITION_ATTRIB] = position;
+	encodings[COLOR_ATTRIB] = color;
+	encodings[TEXCOORD_ATTRIB] = texCoord;
+	encodings[NORMAL_ATTRIB] = normal;
+
+	stride = 0;
+	for (int i = 0; i < NB_VERTEX_ATTRIBS; i++)
+	{
+		offsets[i] = stride;
+		stride += getAttributeSize(encodings[i], NB_COMPONENTS[i]);
+	}
+}
+
+VertexFormat VertexFormat::full()
+{
+	return VertexFormat(ENCODING_FLOAT, ENCODING_FLOAT, ENCODING_FLOAT, ENCODING_FLOAT);
+}
+
+VertexFormat VertexFormat::compact()
+{
+	return VertexFormat(ENCODING_SNORM16, ENCODING_NONE, ENCODING_HALF, ENCODING_SNORM_2_10_10_10);
+}
+
+uint32_t VertexFormat::getKey() const
+{
+	uint32_t key = 0;
+	for (int i = 0; i < NB_VERTEX_ATTRIBS; i++)
+		key |= (uint32_t)encodings[i] << (4 * i);
+	return key;
+}
+
+void VertexFormat::setupAttributes() const
+{
+	for (int i = 0; i < NB_VERTEX_ATTRIBS; i++)
+	{
+		GLvoid* offset = (GLvoid*)(intptr_t)offsets[i];
+
+		switch (encodings[i])
+		{
+		case ENCODING_FLOAT:
+			glVertexAttribPointer(i, NB_COMPONENTS[i], GL_FLOAT, GL_FALSE, stride, offset);
+			break;
+		case ENCODING_HALF:
+			glVertexAttribPointer(i, NB_COMPONENTS[i], GL_HALF_FLOAT, GL_FALSE, stride, offset);
+			break;
+		case ENCODING_SNORM16:
+			glVertexAttribPointer(i, NB_COMPONENTS[i], GL_SHORT, GL_TRUE, stride, offset);
+			break;
+		case ENCODING_SNORM_2_10_10_10:
+			glVertexAttribPointer(i, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset);
+			break;
+		default:
+			glDisableVertexAttribArray(i);
+			continue;
+		}
+
+		glEnableVertexAttribArray(i);
+	}
+}
+
+static unsigned char* writeAttribute(AttributeEncoding encoding, int nbComponents, const float* value, unsigned char* out)
+{
+	float zero[3] = { 0.0f, 0.0f, 0.0f };
+	if (!value)
+		value = zero;
+
+	switch (encoding)
+	{
+	case ENCODING_FLOAT:
+		memcpy(out, value, 4 * nbComponents);
+		break;
+	case ENCODING_HALF:
+		for (int i = 0; i < nbComponents; i++)
+		{
+			uint16_t half = glm::packHalf1x16(value[i]);
+			memcpy(out + 2 * i, &half, 2);
+		}
+		break;
+	case ENCODING_SNORM16:
+		for (int i = 0; i < nbComponents; i++)
+		{
+			uint16_t snorm = glm::packSnorm1x16(value[i]);
+			memcpy(out + 2 * i, &snorm, 2);
+		}
+		break;
+	case ENCODING_SNORM_2_10_10_10:
+	{
+		uint32_t packed = glm::packSnorm3x10_1x2(glm::vec4(value[0], value[1], value[2], 0.0f));
+		memcpy(out, &packed, 4);
+		break;
+	}
+	default:
+		break;
+	}
+
+	return out + getAttributeSize(encoding, nbComponents);
+}
+
+void VertexFormat::writeVertex(const float* position, const float* color, const float* texCoord, const float* normal,
+	const MeshBounds& bounds, unsigned char* out) const
+{
+	memset(out, 0, stride);
+
+	float quantized[3];
+	if (encodings[POSITION_ATTRIB] == ENCODING_SNORM16)
+	{
+		// Posicao relativa ao centro da AABB, em [-1, 1]
+		float center[3], halfExtent[3];
+		bounds.getCenter(center);
+		bounds.getHalfExtent(halfExtent);
+		for (int i = 0; i < 3; i++)
+			quantized[i] = (position[i] - center[i]) / halfExtent[i];
+		position = quantized;
+	}
+
+	out = writeAttribute(encodings[POSITION_ATTRIB], NB_COMPONENTS[POSITION_ATTRIB], position, out);
+	out = writeAttribute(encodings[COLOR_ATTRIB], NB_COMPONENTS[COLOR_ATTRIB], color, out);
+	out = writeAttribute(encodings[TEXCOORD_ATTRIB], NB_COMPONENTS[TEXCOORD_ATTRIB], texCoord, out);
+	writeAttribute(encodings[NORMAL_ATTRIB], NB_COMPONENTS[NORMAL_ATTRIB], normal, out);
+}
+
+void VertexFormat::getDequantization(const MeshBounds& bounds, float offset[3], float scale[3]) const
+{
+	if (encodings[POSITION_ATTRIB] == ENCODING_SNORM16)
+	{
+		bounds.getCenter(offset);
+		bounds.getHalfExtent(scale);
+		return;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		offset[i] = 0.0f;
+		scale[i] = 1.0f;
+	}
+}
@@ -1,30 +1,30 @@
+#include <cstdio>
 #include <iostream>
 #include <string>
-#include <assert.h>
-#include <fstream>
-#include <vector>
-#include <sstream>
-#include <map>
 
 #include <glad/glad.h>
 
 #include <GLFW/glfw3.h>
 
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 
-#include "stb_image.h"
-#include "Shader.h"
-#include "Bezier.h"
+#include "Scene.h"
+#include "FrameClock.h"
 
 using namespace std;
 
 const GLuint WIDTH = 1000, HEIGHT = 1000;
+const char* TITLE = "M6 - Trajetoria de Objetos - Felipe Tremarin";
+// Limite de frames por segundo da tecla F
+const double FRAME_LIMIT = 60.0;
 
 bool rotateX = false;
 bool rotateY = false;
 bool rotateZ = false;
+bool clusterCulling = true;
+bool lodSelection = true;
+bool frameLimit = false;
+bool profileReport = false;
 bool defaultMouse = true;
 
 float lastX;
@@ -33,163 +33,23 @@ float sensitivity = 0.05;
 float pitch = 0.0;
 float yaw = -90.0;
 
-int verticesSize = 0;
-
 string objFile = "../models/SuzanneTriTextured.obj";
 string mtlFile = "../materials/SuzanneTriTextured.mtl";
-string curvesFile = "../animations/curves.txt";
 
 glm::vec3 cameraPos = glm::vec3(0.0, 0.0, 3.0);
 glm::vec3 cameraFront = glm::vec3(0.0, 0.0, -1.0);
 glm::vec3 cameraUp = glm::vec3(0.0, 1.0, 0.0);
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
-int setupGeometry();
-void readMaterialsFile(string filename, map<string, string>& properties);
-float stofOrElse(string value, float def);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-int loadTexture(string path);
-vector<glm::vec3> generateControlPoints(string filename);
-
-struct Vertex {
-	float x, y, z, r = 0.4f, g = 0.1f, b = 0.4f;
-};
-
-struct Texture {
-	float s, t;
-};
-
-struct Normal {
-	float x, y, z;
-};
-
-struct Face {
-	Vertex vertices[3];
-	Texture textures[3];
-	Normal normals[3];
-};
-
-vector<string> splitString(const string& input, char delimiter) {
-	vector<string> tokens;
-	istringstream iss(input);
-	string token;
-
-	while (getline(iss, token, delimiter)) {
-		tokens.push_back(token);
-	}
-
-	return tokens;
-}
-
-vector<float> parseObjToVertices(const string& filename) {
-	ifstream file(filename);
-
-	vector<Vertex> uniqueVertices;
-	vector<Texture> uniqueTextures;
-	vector<Normal> uniqueNormals;
-	vector<Face> faces;
-
-	vector<float> buffer;
-
-	if (!file.is_open()) {
-		cout << "Unable to open the file: " << filename << endl;
-		return buffer;
-	}
-
-	string line;
-
-	while (getline(file, line)) {
-		vector<string> row = splitString(line, ' ');
-
-		if (row.empty())
-			continue;
-
-		if (row[0] == "v") {
-			float x = stof(row[1]);
-			float y = stof(row[2]);
-			float z = stof(row[3]);
-
-			Vertex vertex;
-			vertex.x = x;
-			vertex.y = y;
-			vertex.z = z;
-
-			uniqueVertices.push_back(vertex);
-		}
-
-		if (row[0] == "vt") {
-			float s = stof(row[1]);
-			float t = stof(row[2]);
-
-			Texture texture;
-			texture.s = s;
-			texture.t = t;
-
-			uniqueTextures.push_back(texture);
-		}
-
-		if (row[0] == "vn") {
-			float nx = stof(row[1]);
-			float ny = stof(row[2]);
-			float nz = stof(row[3]);
-
-			Normal normal;
-			normal.x = nx;
-			normal.y = ny;
-			normal.z = nz;
-
-			uniqueNormals.push_back(normal);
-		}
-
-		if (row[0] == "f") {
-			Face face;
-
-			for (int i = 1; i <= 3; ++i) {
-				vector<string> indices = splitString(row[i], '/');
-
-				int vIndex = stoi(indices[0]) - 1;
-				int tIndex = stoi(indices[1]) - 1;
-				int nIndex = stoi(indices[2]) - 1;
-
-				face.vertices[i - 1] = uniqueVertices[vIndex];
-				face.textures[i - 1] = uniqueTextures[tIndex];
-				face.normals[i - 1] = uniqueNormals[nIndex];
-			}
-
-			faces.push_back(face);
-		}
-	}
-
-	file.close();
-
-	for (const auto& face : faces) {
-		for (int i = 0; i < 3; ++i) {
-			buffer.push_back(face.vertices[i].x);
-			buffer.push_back(face.vertices[i].y);
-			buffer.push_back(face.vertices[i].z);
-
-			buffer.push_back(face.vertices[i].r);
-			buffer.push_back(face.vertices[i].g);
-			buffer.push_back(face.vertices[i].b);
-
-			buffer.push_back(face.textures[i].s);
-			buffer.push_back(face.textures[i].t);
-
-			buffer.push_back(face.normals[i].x);
-			buffer.push_back(face.normals[i].y);
-			buffer.push_back(face.normals[i].z);
-		}
-	}
-
-	return buffer;
-}
-
 
 int main()
 {
 	glfwInit();
 
-	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "M6 - Trajetoria de Objetos - Felipe Tremarin", nullptr, nullptr);
+	double startTime = glfwGetTime();
+
+	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, nullptr, nullptr);
 	glfwMakeContextCurrent(window);
 
 	glfwSetKeyCallback(window, key_callback);
@@ -203,6 +63,8 @@ int main()
 	{
 		cout << "Failed to initialize GLAD" << endl;
 	}
+	// Funcoes alem da 3.3 (buffer persistente do FrameData), quando o driver tem
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 	const GLubyte* renderer = glGetString(GL_RENDERER);
 	const GLubyte* version = glGetString(GL_VERSION);
@@ -213,197 +75,84 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
-	Shader shader("../shaders/shaders.vs", "../shaders/shaders.fs");
-
-	GLuint VAO = setupGeometry();
-
-	glUseProgram(shader.ID);
-
-	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
-	shader.setMat4("view", value_ptr(view));
-
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
-	shader.setMat4("projection", glm::value_ptr(projection));
-
-	glm::mat4 model = glm::mat4(1);
-
-	model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	shader.setMat4("model", glm::value_ptr(model));
-
-	map<string, string> properties;
-	readMaterialsFile(mtlFile, properties);
-
-	GLuint texID = loadTexture(properties["map_Kd"]);
-
-	glUniform1i(glGetUniformLocation(shader.ID, "tex_buffer"), 0);
-
-	shader.setFloat("ka", stofOrElse(properties["Ka"], 0));
-	shader.setFloat("kd", stofOrElse(properties["Kd"], 1.5));
-	shader.setFloat("ks", stofOrElse(properties["Ks"], 0));
-	shader.setFloat("q", stofOrElse(properties["Ns"], 0));
-
-	shader.setVec3("lightPos", -2.0f, 10.0f, 3.0f);
-	shader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-
-	glEnable(GL_DEPTH_TEST);
-
-	vector<glm::vec3> controlPoints = generateControlPoints(curvesFile);
-
-	Bezier bezier;
-	bezier.setControlPoints(controlPoints);
-	bezier.setShader(&shader);
-	bezier.generateCurve(1500);
-
-	int nbCurvePoints = bezier.getNbCurvePoints();
-	int i = 0;
-
-	while (!glfwWindowShouldClose(window))
 	{
-		glfwPollEvents();
+		// Destruida antes do glfwTerminate, enquanto o contexto ainda existe
+		Scene scene(width, height, objFile, mtlFile);
 
-		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		int nbFrames = 0;
+		bool assetsReported = false;
 
-		glLineWidth(10);
-		glPointSize(20);
+		// A simulacao anda em passos fixos, independente de quantos frames sao desenhados
+		FrameClock clock;
+		double rateStart = FrameClock::now();
+		long long rateFrames = 0, rateSteps = 0;
 
-		float angle = (GLfloat)glfwGetTime();
-
-		model = glm::mat4(1);
-
-		model = glm::translate(model, bezier.getPointOnCurve(i));
-
-		if (rotateX)
+		while (!glfwWindowShouldClose(window))
 		{
-			model = glm::rotate(model, angle, glm::vec3(1.0f, 0.0f, 0.0f));
+			glfwPollEvents();
+
+			scene.setCamera(cameraPos, cameraFront, cameraUp);
+			scene.setRotationAxis(glm::vec3(rotateX ? 1.0f : 0.0f, rotateY ? 1.0f : 0.0f, rotateZ ? 1.0f : 0.0f));
+			scene.setClusterCulling(clusterCulling);
+			scene.setLodSelection(lodSelection);
+			clock.setFrameLimit(frameLimit ? FRAME_LIMIT : 0.0);
+
+			int steps = clock.tick();
+			for (int i = 0; i < steps; i++)
+				scene.update(clock.getStep());
+
+			scene.drawFrame(clock.getAlpha());
+
+			// Tempo de GPU de cada passada nos ultimos frames
+			if (profileReport)
+			{
+				profileReport = false;
+				cout << "GPU time per pass:" << endl;
+				scene.getProfiler().report(cout);
+			}
 
-		}
-		else if (rotateY)
-		{
-			model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			glfwSwapBuffers(window);
+			clock.limitFrame();
+
+			// Frames desenhados e passos da simulacao por segundo, no titulo da janela
+			double now = FrameClock::now();
+			if (now - rateStart >= 1.0)
+			{
+				char title[128];
+				snprintf(title, sizeof(title), "%s - %.0f fps, %.0f updates/s", TITLE, (clock.getNbFrames() - rateFrames) / (now - rateStart),
+					(clock.getNbSteps() - rateSteps) / (now - rateStart));
+				glfwSetWindowTitle(window, title);
+
+				rateStart = now;
+				rateFrames = clock.getNbFrames();
+				rateSteps = clock.getNbSteps();
+			}
 
+			nbFrames++;
+			if (nbFrames == 1)
+			{
+				cout << "Time to first frame: " << (glfwGetTime() - startTime) * 1000.0 << " ms" << endl;
+			}
+			if (!assetsReported && scene.isLoaded())
+			{
+				assetsReported = true;
+				cout << "Assets loaded after " << (glfwGetTime() - startTime) * 1000.0 << " ms (" << nbFrames << " frames)" << endl;
+				scene.printStats();
+
+				// Os programas terminam em segundo plano, junto com os assets
+				const ShaderTiming& shaders = Shader::getTotalTiming();
+				cout << "Shaders: " << shaders.nbPrograms << " programs, " << shaders.nbCached << " from cache, compile "
+					<< shaders.compileMs << " ms, link " << shaders.linkMs << " ms, wait " << shaders.waitMs << " ms, cache "
+					<< shaders.cacheMs << " ms" << endl;
+			}
 		}
-		else if (rotateZ)
-		{
-			model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-		}
-
-		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-		shader.setMat4("view", glm::value_ptr(view));
-
-		shader.setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
-
-		model = glm::scale(model, glm::vec3(0.5, 0.5, 0.5));
-
-		shader.setMat4("model", glm::value_ptr(model));
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texID);
-
-		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, verticesSize);
-
-		glBindVertexArray(0);
-
-		i = (i + 1) % nbCurvePoints;
-
-		glfwSwapBuffers(window);
 	}
 
-	glDeleteVertexArrays(1, &VAO);
-
 	glfwTerminate();
 
 	return 0;
 }
 
-void readMaterialsFile(string filename, map<string, string>& properties)
-{
-	ifstream file(filename);
-
-	if (!file)
-	{
-		cout << "Unable to open the file: " << filename << endl;
-		return;
-	}
-
-	string line;
-
-	while (getline(file, line))
-	{
-		istringstream iss(line);
-		vector<string> row(istream_iterator<string>{iss}, istream_iterator<string>{});
-
-		if (row.empty())
-		{
-			continue;
-		}
-
-		properties[row[0]] = row[1];
-	}
-
-	file.close();
-}
-
-int loadTexture(string path)
-{
-	GLuint texID;
-
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, nrChannels;
-	unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		if (nrChannels == 3) //jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else //png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return texID;
-}
-
-
-float stofOrElse(string value, float def)
-{
-	if (value.empty())
-	{
-		return def;
-	}
-
-	try
-	{
-		return stof(value);
-	}
-	catch (const exception& e)
-	{
-		cout << "Error converting string to float: " << e.what() << endl;
-		return def;
-	}
-}
-
 
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
@@ -432,6 +181,29 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		rotateZ = true;
 	}
 
+	if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		clusterCulling = !clusterCulling;
+		cout << "Cluster culling " << (clusterCulling ? "on" : "off") << endl;
+	}
+
+	if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		lodSelection = !lodSelection;
+		cout << "LOD selection " << (lodSelection ? "on" : "off") << endl;
+	}
+
+	if (key == GLFW_KEY_P && action == GLFW_PRESS)
+	{
+		profileReport = true;
+	}
+
+	if (key == GLFW_KEY_F && action == GLFW_PRESS)
+	{
+		frameLimit = !frameLimit;
+		cout << "Frame limit " << (frameLimit ? "on" : "off") << endl;
+	}
+
 	float cameraSpeed = 0.01f;
 
 	if (action == GLFW_REPEAT)
@@ -498,73 +270,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 
 	cameraFront = glm::normalize(front);
 }
-
-
-int setupGeometry()
-{
-	vector<float> vertices = parseObjToVertices(objFile);
-
-	verticesSize = vertices.size();
-
-	GLuint VBO, VAO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	return VAO;
-}
-
-
-vector<glm::vec3> generateControlPoints(string filename)
-{
-	ifstream file(filename);
-	vector<glm::vec3> points;
-
-	if (file.is_open()) {
-		string line;
-
-		while (getline(file, line)) {
-			vector<string> row = splitString(line, ',');
-
-			if (row.empty()) {
-				continue;
-			}
-
-			glm::vec3 point;
-			point.x = stofOrElse(row[0], 0.0f);
-			point.y = stofOrElse(row[1], 0.0f);
-			point.z = stofOrElse(row[2], 0.0f);
-
-			points.push_back(point);
-		}
-
-		file.close();
-	}
-	else {
-		cout << "Unable to open the file: " << filename << endl;
-	}
-
-	return points;
-}
-
-
-
-
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "ShaderManager.h"
+#include "Bezier.h"
+#include "MeshCache.h"
+#include "AssetLoader.h"
+#include "MaterialLibrary.h"
+#include "Meshlets.h"
+#include "FrameUniforms.h"
+#include "RenderQueue.h"
+#include "GpuProfiler.h"
+#include "VertexFormat.h"
+
+using namespace std;
+
+// Malha carregada em segundo plano. A thread de trabalho le o cache (ou o .obj) e o
+// render thread envia os dados para a GPU em partes de UPLOAD_SLICE bytes.
+struct GeometryLoad
+{
+	string objFile;
+	string mtlFile;
+	bool streaming = false;
+	// Formato dos vertices na GPU (e no cache)
+	VertexFormat vertexFormat = VertexFormat::compact();
+
+	MeshCache cache;
+	vector<unsigned char> vertices;
+	vector<GLuint> indices;
+	CookedMesh mesh;
+	// Materiais das linhas mtllib do .obj e de mtlFile
+	MaterialLibrary materials;
+
+	// Streaming: blocos ja gravados pelo loader, esperando o envio
+	mutex lock;
+	condition_variable consumed;
+	deque<vector<unsigned char>> pending;
+	bool begun = false;
+	bool finished = false;
+
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	size_t vertexBytesSent = 0;
+	size_t indexBytesSent = 0;
+};
+
+// Textura decodificada em segundo plano e enviada em faixas de linhas
+struct TextureLoad
+{
+	string path;
+	int width = 0, height = 0, nrChannels = 0;
+	unsigned char* data = nullptr;
+
+	int asset = -1;
+	GLuint texID = 0;
+	int rowsSent = 0;
+};
+
+// Submeshes vizinhas com o mesmo material viram uma unica chamada de desenho
+struct DrawBatch
+{
+	const Material* material; // nullptr = valores padrao
+	int texture;              // indice em textures (-1 = textura branca)
+	GLuint first;             // primeiro indice (ou vertice, sem indices)
+	GLsizei count;
+	GLuint firstMeshlet = 0;  // meshlets da faixa (nenhum = desenha a faixa inteira)
+	GLuint nbMeshlets = 0;
+	unsigned features = 0;    // ShaderFeature do material
+	ProgramHandle program = -1; // variante do shader com essas features
+	int normalTexture = -1;   // indice em textures (-1 = sem normal map)
+	// Ka, Kd, Ks e Ns do material, convertidos uma vez (sem material, os padroes)
+	float ka = 0.0f, kd = 1.5f, ks = 0.0f, q = 0.0f;
+};
+
+// Triangulos e meshlets do ultimo frame, antes e depois do descarte
+struct CullingStats
+{
+	size_t nbTriangles = 0;
+	size_t nbTrianglesDrawn = 0;
+	size_t nbMeshlets = 0;
+	size_t nbMeshletsDrawn = 0;
+};
+
+// Uniforms do material, procurados uma vez para cada programa
+struct SceneUniforms
+{
+	UniformHandle ka, kd, ks, q;
+};
+
+// Ponto de ligacao do bloco ObjectData (FrameData fica no FRAME_DATA_BINDING)
+const GLuint OBJECT_DATA_BINDING = 1;
+
+// Bloco std140 ObjectData do shaders.vs: a matriz model do frame (a posicao na curva) e a
+// dequantizacao das posicoes, com os vec3 em vec4
+struct ObjectData
+{
+	glm::mat4 model;
+	glm::vec4 positionOffset;
+	glm::vec4 positionScale;
+};
+
+// A cena do trabalho final: a malha do .obj percorrendo a curva de Bezier.
+// Nao cria janela nem contexto: quem desenha e o Origem.cpp (janela GLFW)
+// ou o FrameBenchmark (contexto EGL sem janela).
+class Scene
+{
+public:
+	// Precisa de um contexto OpenGL atual, com o GLAD e o loadGLExtensions ja carregados
+	Scene(int width, int height, const string& objFile, const string& mtlFile);
+	~Scene();
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+
+	void setCamera(glm::vec3 position, glm::vec3 front, glm::vec3 up);
+	// Eixo em que o objeto gira (vetor nulo = sem rotacao)
+	void setRotationAxis(glm::vec3 axis) { rotationAxis = axis; }
+	// Descarte de meshlets fora do frustum ou de costas para a camera
+	void setClusterCulling(bool enabled) { clusterCulling = enabled; }
+	// Escolha do nivel de detalhe pela distancia (desligada = sempre o nivel 0)
+	void setLodSelection(bool enabled) { lodSelection = enabled; }
+
+	// Um passo fixo da simulacao (step em segundos): anda na curva e gira o objeto
+	void update(double step);
+	// Envia assets por ate UPLOAD_BUDGET_MS e desenha um frame, com o objeto entre o
+	// estado anterior e o atual da simulacao (alpha = FrameClock::getAlpha())
+	void drawFrame(double alpha);
+
+	// Todos os assets na GPU (ou com falha) e todos os programas prontos
+	bool isLoaded() const { return assets.isIdle() && shaders.isIdle(); }
+	// Chamadas de desenho do ultimo frame
+	int getNbDrawCalls() const { return nbDrawCalls; }
+	// Trocas de programa, textura e VAO do ultimo frame
+	const RenderQueueStats& getRenderStats() const { return renderQueue.getStats(); }
+	const CullingStats& getCullingStats() const { return cullingStats; }
+	// Nivel de detalhe do ultimo frame (0 = malha original)
+	int getLod() const { return lod; }
+	// Posicao do objeto na curva desenhada com esse alpha
+	glm::vec3 getObjectPosition(double alpha);
+	void printStats() const { assets.printStats(); }
+	// Tempo de GPU das passadas (upload, clear, opaque), lido com alguns frames de atraso
+	GpuProfiler& getProfiler() { return profiler; }
+
+protected:
+	// Variantes compiladas em segundo plano; shader e o programa em uso (o reserva
+	// enquanto a variante do lote nao fica pronta) e uniforms sao os handles dele
+	ShaderManager shaders;
+	Shader* shader;
+	SceneUniforms uniforms;
+	unordered_map<const Shader*, SceneUniforms> programUniforms;
+	// FrameData e ObjectData de cada frame, no mesmo anel
+	FrameUniforms frameUniforms;
+	// VAO em uso: o do cubo ate a malha chegar, depois geometry.VAO
+	GLuint VAO;
+	// Buffers do cubo, apagados na troca pela malha
+	GLuint placeholderVBO, placeholderEBO;
+	// Indices da malha em uso (0 = malha em streaming, desenhada sem indices)
+	int indicesSize;
+	// Lotes de cada nivel de detalhe (drawBatches[0] = malha original)
+	vector<vector<DrawBatch>> drawBatches;
+	// Dequantizacao das posicoes da malha em uso, enviada no ObjectData
+	glm::vec3 positionOffset, positionScale;
+	// Placeholders: textura branca e normal map plano
+	GLuint texID;
+	GLuint normalTexID;
+
+	GeometryLoad geometry;
+	vector<unique_ptr<TextureLoad>> textures;
+	// Declarado depois de geometry/textures: as threads de trabalho terminam antes deles
+	AssetLoader assets;
+	int meshAsset;
+
+	Bezier bezier;
+	int nbCurvePoints;
+	// Estado da simulacao e o do passo anterior, para a interpolacao: a posicao na curva
+	// (em pontos, com fracao) e o angulo de rotacao
+	double curvePosition, previousCurvePosition;
+	double angle, previousAngle;
+
+	glm::vec3 cameraPos, cameraFront, cameraUp;
+	glm::vec3 rotationAxis;
+	glm::mat4 projection;
+	int height;
+	int nbDrawCalls;
+
+	bool lodSelection;
+	int lod;
+
+	bool clusterCulling;
+	ClusterCuller culler;
+	CullingStats cullingStats;
+	// Faixas de meshlets visiveis de um lote, para o glMultiDrawElements
+	vector<GLsizei> clusterCounts;
+	vector<const void*> clusterOffsets;
+
+	// Chamadas de desenho do frame, ordenadas por estado antes de executar
+	RenderQueue renderQueue;
+
+	GpuProfiler profiler;
+
+	// Cubo mostrado enquanto a malha carrega: cria o VAO e os buffers e devolve o numero
+	// de indices
+	int setupPlaceholderGeometry();
+	// Roda no render thread, quando a malha fica pronta: monta os lotes de cada nivel
+	void setupDrawBatches();
+
+	// Uniforms do programa do comando (o glUseProgram e da RenderQueue). Os handles e os
+	// blocos de cada programa sao configurados uma vez; model e a dequantizacao vem do
+	// ObjectData, entao nao ha uniforms por objeto
+	void setupProgram(Shader& program);
+
+	// Nivel com erro projetado de ate LOD_PIXEL_ERROR pixels, com histerese para nao
+	// ficar trocando de nivel na fronteira
+	int selectLod(const glm::mat4& model, int nbLods);
+};
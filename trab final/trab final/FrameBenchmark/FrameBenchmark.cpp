@@ -0,0 +1,486 @@
+// Benchmark de frames da cena do trab final, sem janela.
+//
+// Cria um contexto OpenGL 4.5 com EGL sem superficie (roda no llvmpipe do Mesa,
+// sem GPU), desenha a cena num framebuffer proprio e mede, por frame, o tempo de
+// CPU (montar e enviar os comandos), o tempo de GPU (GL_TIME_ELAPSED), as
+// chamadas de desenho, as trocas de estado (programa, textura e VAO) que sobram
+// depois da RenderQueue, o nivel de detalhe escolhido e os triangulos descartados
+// pelo teste de meshlets.
+// Antes da medicao espera todos os assets carregarem e todos os programas ficarem prontos.
+// O tempo de criar os programas (compile e link, espera pelo driver, ou leitura do
+// ProgramCache) sai numa linha separada; com --no-program-cache eles sempre sao compilados.
+//
+// Uso: FrameBenchmark [--frames N] [--warmup N] [--size LxA] [--obj arquivo.obj]
+//                     [--mtl arquivo.mtl] [--camera fixed|orbit|follow|zoom] [--no-cull]
+//                     [--no-lod] [--no-program-cache] [--realtime] [--fps-limit N]
+//                     [--csv arquivo.csv] [--profile-csv arquivo.csv]
+// Cameras: fixed = a posicao inicial do Exericio8; orbit = gira em volta da curva;
+// follow = perto do objeto, que fica em parte fora da tela; zoom = segue o objeto
+// afastando e aproximando (de 2 a 40 unidades), passando pelos niveis de detalhe.
+// A simulacao anda um passo fixo por frame, para duas execucoes desenharem os mesmos
+// frames; com --realtime ela segue o relogio, como no Exericio8, e a linha "updates"
+// mostra quantos passos couberam em cada frame. --fps-limit limita os frames medidos.
+// Roda de dentro da pasta FrameBenchmark, como o Exericio8: os caminhos sao relativos.
+// Com --csv a linha do resultado e acrescentada ao arquivo. O tempo de GPU de cada passada
+// da cena (GpuProfiler) sai nas linhas "pass"; com --profile-csv vai uma linha por passada
+// para o arquivo. No llvmpipe os timestamps sao gravados no envio dos comandos, nao em
+// volta da rasterizacao (que so acontece no flush): as passadas ficam perto de zero.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "Scene.h"
+#include "FrameClock.h"
+
+using namespace std;
+
+namespace fs = std::filesystem;
+
+typedef chrono::steady_clock Clock;
+
+// Quantos frames a leitura das queries fica atrasada, para nao esperar pela GPU
+const int QUERY_LATENCY = 3;
+
+// Tempo maximo esperando os assets antes de medir
+const double LOAD_TIMEOUT_MS = 60000.0;
+
+struct OffscreenContext
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	GLuint FBO = 0;
+	GLuint colorBuffer = 0, depthBuffer = 0;
+};
+
+static double elapsedMs(Clock::time_point from, Clock::time_point to)
+{
+	return chrono::duration<double, milli>(to - from).count();
+}
+
+// Identifica a execucao nos CSVs, como no LoaderBenchmark
+static string runIdentifier()
+{
+	char runId[32];
+	time_t now = time(nullptr);
+	strftime(runId, sizeof(runId), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+	return runId;
+}
+
+// Contexto sem janela: EGL_MESA_platform_surfaceless se existir, senao o display padrao
+static bool createContext(OffscreenContext& offscreen, int width, int height)
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (getPlatformDisplay)
+		offscreen.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (offscreen.display == EGL_NO_DISPLAY)
+		offscreen.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (offscreen.display == EGL_NO_DISPLAY || !eglInitialize(offscreen.display, &major, &minor))
+	{
+		cerr << "Failed to initialize EGL" << endl;
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+
+	// Os shaders sao #version 450
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	offscreen.context = eglCreateContext(offscreen.display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+	if (offscreen.context == EGL_NO_CONTEXT
+		|| !eglMakeCurrent(offscreen.display, EGL_NO_SURFACE, EGL_NO_SURFACE, offscreen.context))
+	{
+		cerr << "Failed to create an OpenGL 4.5 context (EGL error 0x" << hex << eglGetError() << dec << ")" << endl;
+		return false;
+	}
+
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+	{
+		cerr << "Failed to initialize GLAD" << endl;
+		return false;
+	}
+	loadGLExtensions((GLADloadproc)eglGetProcAddress);
+
+	// Sem superficie, a cena e desenhada num framebuffer do tamanho da janela do Exericio8
+	glGenRenderbuffers(1, &offscreen.colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen.colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &offscreen.depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen.depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &offscreen.FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen.FBO);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen.colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreen.depthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cerr << "Offscreen framebuffer is incomplete" << endl;
+		return false;
+	}
+
+	glViewport(0, 0, width, height);
+
+	return true;
+}
+
+static void destroyContext(OffscreenContext& offscreen)
+{
+	if (offscreen.FBO)
+	{
+		glDeleteFramebuffers(1, &offscreen.FBO);
+		glDeleteRenderbuffers(1, &offscreen.colorBuffer);
+		glDeleteRenderbuffers(1, &offscreen.depthBuffer);
+	}
+
+	if (offscreen.display != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(offscreen.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (offscreen.context != EGL_NO_CONTEXT)
+			eglDestroyContext(offscreen.display, offscreen.context);
+		eglTerminate(offscreen.display);
+	}
+}
+
+// Caminho da camera no frame (time em segundos, alpha do objeto desenhado)
+static void placeCamera(Scene& scene, const string& path, double time, double alpha)
+{
+	glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+	if (path == "fixed")
+	{
+		scene.setCamera(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f), up);
+	}
+	else if (path == "orbit")
+	{
+		float angle = (float)time * 0.5f;
+		glm::vec3 target(0.0f, 0.0f, 0.5f);
+		glm::vec3 position = target + glm::vec3(3.0f * sin(angle), 0.5f, 3.0f * cos(angle));
+		scene.setCamera(position, glm::normalize(target - position), up);
+	}
+	else if (path == "follow")
+	{
+		glm::vec3 target = scene.getObjectPosition(alpha);
+		glm::vec3 position = target + glm::vec3(0.3f, 0.3f, 1.2f);
+		scene.setCamera(position, glm::normalize(target - position), up);
+	}
+	else
+	{
+		float distance = 21.0f - 19.0f * cos((float)time * 1.2f);
+		glm::vec3 target = scene.getObjectPosition(alpha);
+		glm::vec3 position = target + glm::normalize(glm::vec3(0.25f, 0.25f, 1.0f)) * distance;
+		scene.setCamera(position, glm::normalize(target - position), up);
+	}
+}
+
+// Media, mediana e percentil 95 de uma serie de tempos
+struct FrameStats
+{
+	double meanMs = 0.0;
+	double medianMs = 0.0;
+	double p95Ms = 0.0;
+};
+
+static FrameStats computeStats(vector<double> times)
+{
+	FrameStats stats;
+	if (times.empty())
+		return stats;
+
+	sort(times.begin(), times.end());
+
+	double sum = 0.0;
+	for (double time : times)
+		sum += time;
+
+	stats.meanMs = sum / times.size();
+	stats.medianMs = times[times.size() / 2];
+	stats.p95Ms = times[min(times.size() - 1, times.size() * 95 / 100)];
+
+	return stats;
+}
+
+int main(int argc, char** argv)
+{
+	int nbFrames = 300;
+	int nbWarmupFrames = 30;
+	int width = 1000, height = 1000;
+	string objFile = "../../../3D_Models/Suzanne/SuzanneTriTextured.obj";
+	string mtlFile = "../materials/SuzanneTriTextured.mtl";
+	string cameraPath = "fixed";
+	bool clusterCulling = true;
+	bool lodSelection = true;
+	bool realtime = false;
+	double frameLimit = 0.0;
+	string csvFile;
+	string profileCsvFile;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc)
+			nbFrames = max(atoi(argv[++i]), 1);
+		else if (arg == "--warmup" && i + 1 < argc)
+			nbWarmupFrames = max(atoi(argv[++i]), 0);
+		else if (arg == "--size" && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+			i++;
+		else if (arg == "--obj" && i + 1 < argc)
+			objFile = argv[++i];
+		else if (arg == "--mtl" && i + 1 < argc)
+			mtlFile = argv[++i];
+		else if (arg == "--camera" && i + 1 < argc)
+			cameraPath = argv[++i];
+		else if (arg == "--no-cull")
+			clusterCulling = false;
+		else if (arg == "--no-lod")
+			lodSelection = false;
+		else if (arg == "--no-program-cache")
+			ProgramCache::enabled = false;
+		else if (arg == "--realtime")
+			realtime = true;
+		else if (arg == "--fps-limit" && i + 1 < argc)
+			frameLimit = max(atof(argv[++i]), 0.0);
+		else if (arg == "--csv" && i + 1 < argc)
+			csvFile = argv[++i];
+		else if (arg == "--profile-csv" && i + 1 < argc)
+			profileCsvFile = argv[++i];
+		else
+		{
+			cerr << "Usage: FrameBenchmark [--frames N] [--warmup N] [--size WxH] [--obj file] [--mtl file]"
+				 " [--camera fixed|orbit|follow|zoom] [--no-cull] [--no-lod] [--no-program-cache]"
+				 " [--realtime] [--fps-limit N] [--csv file] [--profile-csv file]" << endl;
+			return 1;
+		}
+	}
+
+	if (cameraPath != "fixed" && cameraPath != "orbit" && cameraPath != "follow" && cameraPath != "zoom")
+	{
+		cerr << "Unknown camera path: " << cameraPath << endl;
+		return 1;
+	}
+
+	error_code error;
+	if (!fs::exists("../shaders/shaders.vs", error))
+	{
+		cerr << "../shaders not found: run FrameBenchmark from its own folder" << endl;
+		return 1;
+	}
+
+	OffscreenContext offscreen;
+	if (!createContext(offscreen, width, height))
+	{
+		destroyContext(offscreen);
+		return 1;
+	}
+
+	string renderer = (const char*)glGetString(GL_RENDERER);
+	cout << "Renderer: " << renderer << endl;
+	cout << "OpenGL version supported " << glGetString(GL_VERSION) << endl;
+
+	vector<double> cpuTimes, gpuTimes;
+	double loadMs = 0.0;
+	int nbLoadFrames = 0;
+	double drawCalls = 0.0;
+	double stateChanges = 0.0, stateRequested = 0.0;
+	size_t nbTriangles = 0, nbTrianglesDrawn = 0;
+	size_t nbMeshlets = 0, nbMeshletsDrawn = 0;
+	double lodSum = 0.0;
+	double wallMs = 0.0;
+	long long nbSteps = 0;
+	vector<GpuScopeStats> passes;
+	size_t nbSkippedPasses = 0;
+	string runId = runIdentifier();
+
+	{
+		Clock::time_point start = Clock::now();
+		Scene scene(width, height, objFile, mtlFile);
+		scene.setClusterCulling(clusterCulling);
+		scene.setLodSelection(lodSelection);
+		placeCamera(scene, cameraPath, 0.0, 0.0);
+
+		// Passos da simulacao do frame; a camera acompanha o estado desenhado
+		FrameClock clock;
+		auto advance = [&]() {
+			int steps = realtime ? clock.tick() : clock.advance(clock.getStep());
+			for (int i = 0; i < steps; i++)
+				scene.update(clock.getStep());
+		};
+
+		// Carregamento, com o mesmo budget de upload por frame do programa com janela
+		while (!scene.isLoaded() && elapsedMs(start, Clock::now()) < LOAD_TIMEOUT_MS)
+		{
+			advance();
+			scene.drawFrame(clock.getAlpha());
+			glFinish();
+		}
+		loadMs = elapsedMs(start, Clock::now());
+		nbLoadFrames = (int)clock.getNbFrames();
+
+		if (!scene.isLoaded())
+			cerr << "Assets still loading after " << LOAD_TIMEOUT_MS << " ms, measuring anyway" << endl;
+		scene.printStats();
+
+		for (int i = 0; i < nbWarmupFrames; i++)
+		{
+			advance();
+			placeCamera(scene, cameraPath, clock.getInterpolatedTime(), clock.getAlpha());
+			scene.drawFrame(clock.getAlpha());
+			glFinish();
+		}
+
+		GLuint queries[QUERY_LATENCY];
+		glGenQueries(QUERY_LATENCY, queries);
+
+		auto readQuery = [&gpuTimes](GLuint query) {
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			gpuTimes.push_back(nanoseconds / 1000000.0);
+		};
+
+		clock.setFrameLimit(frameLimit);
+		long long firstStep = clock.getNbSteps();
+		// So os frames medidos entram nas estatisticas das passadas
+		GpuProfiler& profiler = scene.getProfiler();
+		profiler.finish();
+		profiler.clearStats();
+		Clock::time_point measureStart = Clock::now();
+
+		for (int i = 0; i < nbFrames; i++)
+		{
+			GLuint query = queries[i % QUERY_LATENCY];
+
+			// O resultado de QUERY_LATENCY frames atras: faz o papel do swap, que
+			// impede a CPU de ficar muitos frames a frente da GPU
+			if (i >= QUERY_LATENCY)
+				readQuery(query);
+
+			advance();
+			placeCamera(scene, cameraPath, clock.getInterpolatedTime(), clock.getAlpha());
+
+			glBeginQuery(GL_TIME_ELAPSED, query);
+
+			Clock::time_point cpuStart = Clock::now();
+			scene.drawFrame(clock.getAlpha());
+			cpuTimes.push_back(elapsedMs(cpuStart, Clock::now()));
+
+			// O llvmpipe so rasteriza no flush: dentro da query, para o tempo de GPU conta-lo
+			glFlush();
+			glEndQuery(GL_TIME_ELAPSED);
+			drawCalls += scene.getNbDrawCalls();
+
+			const RenderQueueStats& render = scene.getRenderStats();
+			stateChanges += render.getStateChanges();
+			stateRequested += render.nbRequested;
+
+			const CullingStats& culling = scene.getCullingStats();
+			nbTriangles += culling.nbTriangles;
+			nbTrianglesDrawn += culling.nbTrianglesDrawn;
+			nbMeshlets += culling.nbMeshlets;
+			nbMeshletsDrawn += culling.nbMeshletsDrawn;
+			lodSum += scene.getLod();
+
+			clock.limitFrame();
+		}
+
+		for (int i = max(nbFrames - QUERY_LATENCY, 0); i < nbFrames; i++)
+			readQuery(queries[i % QUERY_LATENCY]);
+
+		glFinish();
+		wallMs = elapsedMs(measureStart, Clock::now());
+		nbSteps = clock.getNbSteps() - firstStep;
+
+		profiler.finish();
+		passes = profiler.getStats();
+		nbSkippedPasses = profiler.getNbSkippedFrames();
+		if (!profileCsvFile.empty() && !profiler.appendCsv(profileCsvFile, runId))
+			cerr << "Unable to write " << profileCsvFile << endl;
+
+		glDeleteQueries(QUERY_LATENCY, queries);
+	}
+
+	destroyContext(offscreen);
+
+	FrameStats cpu = computeStats(cpuTimes);
+	FrameStats gpu = computeStats(gpuTimes);
+	drawCalls /= nbFrames;
+	stateChanges /= nbFrames;
+	stateRequested /= nbFrames;
+	double trianglesCulled = nbTriangles > 0 ? 100.0 * (nbTriangles - nbTrianglesDrawn) / nbTriangles : 0.0;
+	double meshletsCulled = nbMeshlets > 0 ? 100.0 * (nbMeshlets - nbMeshletsDrawn) / nbMeshlets : 0.0;
+
+	printf("%d frames at %dx%d, %s, camera %s, cluster culling %s, LOD %s\n", nbFrames, width, height, objFile.c_str(),
+		cameraPath.c_str(), clusterCulling ? "on" : "off", lodSelection ? "on" : "off");
+	printf("  load      %8.1f ms (%d frames)\n", loadMs, nbLoadFrames);
+	printf("  cpu       mean %7.3f ms  median %7.3f ms  p95 %7.3f ms\n", cpu.meanMs, cpu.medianMs, cpu.p95Ms);
+	printf("  gpu       mean %7.3f ms  median %7.3f ms  p95 %7.3f ms\n", gpu.meanMs, gpu.medianMs, gpu.p95Ms);
+	printf("  fps       %8.1f\n", nbFrames * 1000.0 / wallMs);
+	printf("  updates   %8.2f per frame (%.1f per second, %s)\n", (double)nbSteps / nbFrames, nbSteps * 1000.0 / wallMs,
+		realtime ? "realtime" : "fixed");
+	printf("  draws     %8.1f per frame\n", drawCalls);
+	printf("  state     %8.1f changes per frame (%.1f binds requested)\n", stateChanges, stateRequested);
+	printf("  lod       mean %.2f, %zu triangles per frame (%zu drawn)\n", lodSum / nbFrames, nbTriangles / nbFrames,
+		nbTrianglesDrawn / nbFrames);
+	printf("  culled    %8.1f %% of triangles (%.1f %% of %zu meshlets)\n", trianglesCulled, meshletsCulled, nbMeshlets / nbFrames);
+	for (const GpuScopeStats& pass : passes)
+		printf("  pass %-8s min %7.3f ms  avg %7.3f ms  p99 %7.3f ms\n", pass.name.c_str(), pass.minMs, pass.avgMs, pass.p99Ms);
+	if (nbSkippedPasses > 0)
+		printf("  pass      %zu frames skipped (results not ready)\n", nbSkippedPasses);
+
+	// Criacao dos programas, separada da carga dos assets
+	const ShaderTiming& shaders = Shader::getTotalTiming();
+	printf("  shaders   %d programs, %d from cache (%s), parallel compile %s\n", shaders.nbPrograms, shaders.nbCached,
+		ProgramCache::isSupported() ? "on" : "off", ShaderManager::hasParallelCompile() ? "on" : "off");
+	printf("            read %.1f ms  compile %.1f ms  link %.1f ms  wait %.1f ms  cache %.1f ms\n",
+		shaders.readMs, shaders.compileMs, shaders.linkMs, shaders.waitMs, shaders.cacheMs);
+
+	if (!csvFile.empty())
+	{
+		bool writeHeader = !fs::exists(csvFile, error);
+		ofstream csv(csvFile, ios::app);
+
+		if (writeHeader)
+		{
+			csv << "run,renderer,obj,width,height,frames,load_ms,cpu_mean_ms,cpu_median_ms,cpu_p95_ms,"
+				"gpu_mean_ms,gpu_median_ms,gpu_p95_ms,fps,draw_calls,camera,cluster_culling,triangles_culled_pct,"
+				"lod_selection,mean_lod,triangles_per_frame,programs,programs_cached,shader_compile_ms,shader_link_ms,"
+				"shader_wait_ms,shader_cache_ms,state_changes,state_requested,realtime,updates_per_frame" << endl;
+		}
+
+		replace(renderer.begin(), renderer.end(), ',', ' ');
+
+		char line[1024];
+		snprintf(line, sizeof(line), "%s,%s,%s,%d,%d,%d,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%s,%d,%.1f,%d,%.2f,%zu,%d,%d,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%d,%.2f",
+			runId.c_str(), renderer.c_str(), fs::path(objFile).filename().string().c_str(), width, height, nbFrames, loadMs,
+			cpu.meanMs, cpu.medianMs, cpu.p95Ms, gpu.meanMs, gpu.medianMs, gpu.p95Ms, nbFrames * 1000.0 / wallMs, drawCalls,
+			cameraPath.c_str(), clusterCulling ? 1 : 0, trianglesCulled, lodSelection ? 1 : 0, lodSum / nbFrames, nbTriangles / nbFrames,
+			shaders.nbPrograms, shaders.nbCached, shaders.compileMs, shaders.linkMs, shaders.waitMs, shaders.cacheMs,
+			stateChanges, stateRequested, realtime ? 1 : 0, (double)nbSteps / nbFrames);
+		csv << line << endl;
+	}
+
+	return 0;
+}
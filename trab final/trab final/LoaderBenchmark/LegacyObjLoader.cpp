@@ -0,0 +1,121 @@
+#include "LegacyObjLoader.h"
+
+#include "MeshOptimizer.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+bool legacyLoadObj(const string& filepath, glm::vec3 color, vector<float>& vbuffer, vector<unsigned int>& indices)
+{
+	vector <glm::vec3> vertices;
+	vector <glm::vec2> texCoords;
+	vector <glm::vec3> normals;
+	unordered_map <uint64_t, unsigned int> uniqueVertices;
+
+	vbuffer.clear();
+	indices.clear();
+
+	ifstream inputFile;
+	inputFile.open(filepath.c_str());
+	if (!inputFile.is_open())
+	{
+		cout << "Problema ao encontrar o arquivo " << filepath << endl;
+		return false;
+	}
+
+	char line[100];
+	string sline;
+
+	while (!inputFile.eof())
+	{
+		inputFile.getline(line, 100);
+		sline = line;
+
+		string word;
+
+		istringstream ssline(line);
+		ssline >> word;
+		if (word == "v")
+		{
+			glm::vec3 v;
+			ssline >> v.x >> v.y >> v.z;
+
+			vertices.push_back(v);
+		}
+		if (word == "vt")
+		{
+			glm::vec2 vt;
+			ssline >> vt.s >> vt.t;
+
+			texCoords.push_back(vt);
+		}
+		if (word == "vn")
+		{
+			glm::vec3 vn;
+			ssline >> vn.x >> vn.y >> vn.z;
+			normals.push_back(vn);
+		}
+		if (word == "f")
+		{
+			string tokens[3];
+
+			ssline >> tokens[0] >> tokens[1] >> tokens[2];
+
+			for (int i = 0; i < 3; i++)
+			{
+				//Recuperando os indices de v
+				int pos = tokens[i].find("/");
+				string token = tokens[i].substr(0, pos);
+				int vIndex = atoi(token.c_str()) - 1;
+
+				//Recuperando os indices de vts
+				tokens[i] = tokens[i].substr(pos + 1);
+				pos = tokens[i].find("/");
+				token = tokens[i].substr(0, pos);
+				int tIndex = atoi(token.c_str()) - 1;
+
+				//Recuperando os indices de vns
+				tokens[i] = tokens[i].substr(pos + 1);
+				int nIndex = atoi(tokens[i].c_str()) - 1;
+
+				//Se a tripla v/vt/vn ja apareceu, reaproveita o vertice pelo indice
+				uint64_t key = ((uint64_t)vIndex << 42) | ((uint64_t)tIndex << 21) | (uint64_t)nIndex;
+				auto found = uniqueVertices.find(key);
+				if (found != uniqueVertices.end())
+				{
+					indices.push_back(found->second);
+					continue;
+				}
+
+				unsigned int index = vbuffer.size() / 11;
+				uniqueVertices[key] = index;
+				indices.push_back(index);
+
+				vbuffer.push_back(vertices[vIndex].x);
+				vbuffer.push_back(vertices[vIndex].y);
+				vbuffer.push_back(vertices[vIndex].z);
+				vbuffer.push_back(color.r);
+				vbuffer.push_back(color.g);
+				vbuffer.push_back(color.b);
+				vbuffer.push_back(texCoords[tIndex].s);
+				vbuffer.push_back(texCoords[tIndex].t);
+				vbuffer.push_back(normals[nIndex].x);
+				vbuffer.push_back(normals[nIndex].y);
+				vbuffer.push_back(normals[nIndex].z);
+			}
+		}
+	}
+	inputFile.close();
+
+	//Reordena triangulos e vertices para o cache de vertices e o overdraw
+	MeshOptimizerStats stats;
+	size_t nbVertices = optimizeMesh(vbuffer.data(), vbuffer.size() / 11, 11 * sizeof(float), indices.data(), indices.size(), {},
+		vbuffer.data(), 11 * sizeof(float), stats);
+	vbuffer.resize(nbVertices * 11);
+
+	return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Parte de CPU do loadObj dos modulos M3, M4 e M5 (as tres copias sao iguais): o mesmo
+// codigo, sem o envio para a GPU, para comparar com o ObjLoader no benchmark.
+// Assim como o original, so aceita faces triangulares com v/vt/vn em todos os cantos.
+bool legacyLoadObj(const string& filepath, glm::vec3 color, vector<float>& vbuffer, vector<unsigned int>& indices);
@@ -0,0 +1,456 @@
+// Benchmark dos loaders de assets, sem janela nem contexto OpenGL.
+//
+// Carrega cada .obj/.mtl/imagem de uma pasta (por padrao o 3D_Models da raiz do
+// repositorio) com cada loader e escreve uma linha CSV por combinacao:
+// MB/s, triangulos/s, alocacoes, pico de heap e pico de RSS.
+//
+// Uso: LoaderBenchmark [pasta] [--repeat N] [--csv arquivo.csv]
+// Com --csv as linhas sao acrescentadas ao arquivo, para comparar uma execucao com a outra.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+#include "stb_image.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "MaterialLibrary.h"
+#include "VertexFormat.h"
+#include "LegacyObjLoader.h"
+
+using namespace std;
+
+namespace fs = std::filesystem;
+
+// Contadores de alocacao: todo new/delete do programa passa por aqui
+static atomic<size_t> nbAllocations(0);
+static atomic<size_t> allocatedBytes(0);
+static atomic<size_t> liveBytes(0);
+static atomic<size_t> peakBytes(0);
+
+// Cada bloco guarda o proprio tamanho e o endereco devolvido pelo malloc logo antes dos
+// dados (16 bytes, para manter o alinhamento padrao do new)
+static const size_t HEADER_SIZE = 16;
+
+// nullptr se faltar memoria. alignment e potencia de 2 (as formas com align_val_t)
+static void* countedAlloc(size_t size, size_t alignment = HEADER_SIZE)
+{
+	alignment = max(alignment, HEADER_SIZE);
+	unsigned char* block = (unsigned char*)malloc(size + HEADER_SIZE + alignment - 1);
+	if (!block)
+	{
+		return nullptr;
+	}
+
+	uintptr_t data = ((uintptr_t)block + HEADER_SIZE + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	((size_t*)data)[-2] = size;
+	((void**)data)[-1] = block;
+
+	nbAllocations++;
+	allocatedBytes += size;
+	size_t live = liveBytes += size;
+	size_t peak = peakBytes;
+	while (live > peak && !peakBytes.compare_exchange_weak(peak, live))
+	{
+	}
+
+	return (void*)data;
+}
+
+static void* countedNew(size_t size, size_t alignment = HEADER_SIZE)
+{
+	void* data = countedAlloc(size, alignment);
+	if (!data)
+	{
+		throw bad_alloc();
+	}
+	return data;
+}
+
+static void countedFree(void* data)
+{
+	if (!data)
+	{
+		return;
+	}
+	liveBytes -= ((size_t*)data)[-2];
+	free(((void**)data)[-1]);
+}
+
+// Todas as formas substituiveis: um bloco de qualquer new sempre volta pelo countedFree
+void* operator new(size_t size) { return countedNew(size); }
+void* operator new[](size_t size) { return countedNew(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new(size_t size, align_val_t alignment) { return countedNew(size, (size_t)alignment); }
+void* operator new[](size_t size, align_val_t alignment) { return countedNew(size, (size_t)alignment); }
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept { return countedAlloc(size, (size_t)alignment); }
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept { return countedAlloc(size, (size_t)alignment); }
+
+void operator delete(void* data) noexcept { countedFree(data); }
+void operator delete[](void* data) noexcept { countedFree(data); }
+void operator delete(void* data, const nothrow_t&) noexcept { countedFree(data); }
+void operator delete[](void* data, const nothrow_t&) noexcept { countedFree(data); }
+void operator delete(void* data, size_t) noexcept { countedFree(data); }
+void operator delete[](void* data, size_t) noexcept { countedFree(data); }
+void operator delete(void* data, align_val_t) noexcept { countedFree(data); }
+void operator delete[](void* data, align_val_t) noexcept { countedFree(data); }
+void operator delete(void* data, align_val_t, const nothrow_t&) noexcept { countedFree(data); }
+void operator delete[](void* data, align_val_t, const nothrow_t&) noexcept { countedFree(data); }
+void operator delete(void* data, size_t, align_val_t) noexcept { countedFree(data); }
+void operator delete[](void* data, size_t, align_val_t) noexcept { countedFree(data); }
+
+// Pico de memoria residente do processo, em KB. No Linux o pico e zerado a cada
+// medicao (clear_refs); no Windows e o pico do processo inteiro.
+static void resetPeakRss()
+{
+#ifndef _WIN32
+	ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+#endif
+}
+
+static size_t getPeakRssKb()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize / 1024;
+	}
+	return 0;
+#else
+	ifstream status("/proc/self/status");
+	string line;
+	while (getline(status, line))
+	{
+		if (line.compare(0, 6, "VmHWM:") == 0)
+		{
+			return strtoul(line.c_str() + 6, nullptr, 10);
+		}
+	}
+	return 0;
+#endif
+}
+
+// Um loader: carrega path e informa quantos triangulos leu (0 para .mtl e imagens).
+// Retorna false se o arquivo nao puder ser lido por esse loader.
+struct BenchLoader
+{
+	string name;
+	vector<string> extensions;
+	function<bool(const string& path, size_t& triangles)> load;
+	// Opcional: roda antes da medicao; se retornar false o arquivo e pulado
+	function<bool(const string& path)> prepare;
+};
+
+struct BenchResult
+{
+	size_t triangles = 0;
+	int repeats = 0;
+	double minMs = 0.0;
+	double medianMs = 0.0;
+	size_t allocations = 0;
+	size_t allocatedBytes = 0;
+	size_t peakHeapBytes = 0;
+	size_t peakRssKb = 0;
+};
+
+static bool runLoader(const BenchLoader& loader, const string& path, int repeats, BenchResult& result)
+{
+	// Aquecimento: cache de disco e primeira alocacao das estruturas
+	if (!loader.load(path, result.triangles))
+	{
+		return false;
+	}
+
+	vector<double> times;
+	size_t allocationsBefore = nbAllocations;
+	size_t bytesBefore = allocatedBytes;
+
+	resetPeakRss();
+	peakBytes = liveBytes.load();
+	size_t heapBefore = liveBytes;
+
+	for (int i = 0; i < repeats; i++)
+	{
+		auto start = chrono::steady_clock::now();
+		loader.load(path, result.triangles);
+		times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	}
+
+	sort(times.begin(), times.end());
+
+	result.repeats = repeats;
+	result.minMs = times.front();
+	result.medianMs = times[times.size() / 2];
+	result.allocations = (nbAllocations - allocationsBefore) / repeats;
+	result.allocatedBytes = (allocatedBytes - bytesBefore) / repeats;
+	result.peakHeapBytes = peakBytes - heapBefore;
+	result.peakRssKb = getPeakRssKb();
+
+	return true;
+}
+
+// So roda o loadObj antigo em arquivos que ele consegue ler sem sair dos vetores:
+// todos os cantos com v/vt/vn e sem indices negativos
+static bool hasFullTriangleCorners(const string& path)
+{
+	ifstream file(path);
+	string line;
+	bool hasFaces = false;
+
+	while (getline(file, line))
+	{
+		if (line.compare(0, 2, "f ") != 0)
+		{
+			continue;
+		}
+		hasFaces = true;
+
+		istringstream tokens(line.substr(2));
+		string token;
+		int nbCorners = 0;
+		while (tokens >> token)
+		{
+			size_t first = token.find('/');
+			size_t second = first == string::npos ? string::npos : token.find('/', first + 1);
+			if (second == string::npos || second == first + 1 || second + 1 >= token.size() || token.find('-') != string::npos)
+			{
+				return false;
+			}
+			nbCorners++;
+		}
+		if (nbCorners != 3)
+		{
+			return false;
+		}
+	}
+
+	return hasFaces;
+}
+
+static vector<BenchLoader> createLoaders(const string& cacheDir)
+{
+	VertexFormat format = VertexFormat::compact();
+	vector<BenchLoader> loaders;
+
+	// Leitura e indexacao sem o cook (LODs, otimizacao e meshlets): o mesmo trabalho do
+	// loadObj antigo, para a comparacao ser justa. O cook tem a linha dele
+	loaders.push_back({ "parseObjToVertices", { ".obj" }, [format](const string& path, size_t& triangles) {
+		ObjLoader loader;
+		vector<unsigned char> vertices;
+		vector<unsigned int> indices;
+		MeshBounds bounds;
+		MeshParts parts;
+		if (!loader.loadFileParallel(path))
+			return false;
+		loader.buildIndexed(format, vertices, indices, bounds, parts, nullptr, false);
+		triangles = loader.getMesh().getNbTriangles();
+		return true;
+	}, nullptr });
+
+	loaders.push_back({ "ObjLoader::loadFile", { ".obj" }, [format](const string& path, size_t& triangles) {
+		ObjLoader loader;
+		vector<unsigned char> vertices;
+		vector<unsigned int> indices;
+		MeshBounds bounds;
+		MeshParts parts;
+		if (!loader.loadFile(path))
+			return false;
+		loader.buildIndexed(format, vertices, indices, bounds, parts, nullptr, false);
+		triangles = loader.getMesh().getNbTriangles();
+		return true;
+	}, nullptr });
+
+	// O que o parseObjToVertices do trab final / M6 faz de fato: leitura, indexacao e cook
+	loaders.push_back({ "parseObjToVertices + cook", { ".obj" }, [format](const string& path, size_t& triangles) {
+		ObjLoader loader;
+		vector<unsigned char> vertices;
+		vector<unsigned int> indices;
+		MeshBounds bounds;
+		MeshParts parts;
+		if (!loader.loadFileParallel(path))
+			return false;
+		loader.buildIndexed(format, vertices, indices, bounds, parts);
+		// indices tambem tem os niveis de detalhe
+		triangles = loader.getMesh().getNbTriangles();
+		return true;
+	}, nullptr });
+
+	loaders.push_back({ "ObjLoader::loadFileStreaming", { ".obj" }, [format](const string& path, size_t& triangles) {
+		ObjLoader loader;
+		size_t nbVertices = 0;
+		bool ok = loader.loadFileStreaming(path, format, 4 * 1024 * 1024,
+			[](size_t, const MeshBounds&) {}, [](const void*, size_t, size_t) {}, nbVertices);
+		triangles = nbVertices / 3;
+		return ok;
+	}, nullptr });
+
+	// Cache ja gravado (fora da medicao): so o custo de mapear e validar
+	loaders.push_back({ "MeshCache::open", { ".obj" }, [cacheDir](const string& path, size_t& triangles) {
+		MeshCache cache(cacheDir);
+		if (!cache.open(path))
+			return false;
+		triangles = 0;
+		for (const Submesh& submesh : cache.getMesh().parts.submeshes)
+			triangles += submesh.nbIndices / 3;
+		return true;
+	}, [format, cacheDir](const string& path) {
+		ObjLoader loader;
+		CookedMesh mesh;
+		vector<unsigned char> vertices;
+		vector<unsigned int> indices;
+		if (!loader.loadFile(path))
+			return false;
+		loader.buildIndexed(format, vertices, indices, mesh.bounds, mesh.parts);
+		mesh.vertices = vertices.data();
+		mesh.vertexFormat = format.getKey();
+		mesh.vertexStride = format.getStride();
+		mesh.nbVertices = vertices.size() / format.getStride();
+		mesh.indices = indices.data();
+		mesh.nbIndices = indices.size();
+		return MeshCache(cacheDir).write(path, mesh);
+	} });
+
+	loaders.push_back({ "loadObj (M3/M4/M5)", { ".obj" }, [](const string& path, size_t& triangles) {
+		vector<float> vbuffer;
+		vector<unsigned int> indices;
+		if (!legacyLoadObj(path, glm::vec3(1.0, 0.0, 1.0), vbuffer, indices))
+			return false;
+		triangles = indices.size() / 3;
+		return true;
+	}, hasFullTriangleCorners });
+
+	loaders.push_back({ "MaterialLibrary::loadFile", { ".mtl" }, [](const string& path, size_t& triangles) {
+		MaterialLibrary materials;
+		triangles = 0;
+		return materials.loadFile(path);
+	}, nullptr });
+
+	loaders.push_back({ "stbi_load", { ".png", ".jpg", ".bmp" }, [](const string& path, size_t& triangles) {
+		int width, height, nrChannels;
+		unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+		triangles = 0;
+		stbi_image_free(data);
+		return data != nullptr;
+	}, nullptr });
+
+	return loaders;
+}
+
+int main(int argc, char** argv)
+{
+	string modelsDir = "../../../3D_Models";
+	string csvFile;
+	int repeats = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--repeat" && i + 1 < argc)
+			repeats = max(atoi(argv[++i]), 1);
+		else if (arg == "--csv" && i + 1 < argc)
+			csvFile = argv[++i];
+		else
+			modelsDir = arg;
+	}
+
+	error_code error;
+	if (!fs::is_directory(modelsDir, error))
+	{
+		cerr << "Pasta de modelos nao encontrada: " << modelsDir << endl;
+		return 1;
+	}
+
+	vector<string> files;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(modelsDir, error))
+	{
+		if (entry.is_regular_file())
+			files.push_back(entry.path().generic_string());
+	}
+	sort(files.begin(), files.end());
+
+	string cacheDir = (fs::temp_directory_path(error) / "loader-benchmark-cache/").string();
+	vector<BenchLoader> loaders = createLoaders(cacheDir);
+
+	// Identifica a execucao nas linhas acrescentadas ao CSV
+	char runId[32];
+	time_t now = time(nullptr);
+	strftime(runId, sizeof(runId), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	bool writeHeader = csvFile.empty() || !fs::exists(csvFile, error);
+	ofstream csv;
+	if (!csvFile.empty())
+	{
+		csv.open(csvFile, ios::app);
+	}
+	ostream& out = csvFile.empty() ? cout : csv;
+
+	if (writeHeader)
+	{
+		out << "run,loader,file,file_bytes,triangles,repeats,min_ms,median_ms,mb_per_s,triangles_per_s,"
+			"allocations,allocated_bytes,peak_heap_bytes,peak_rss_kb" << endl;
+	}
+
+	for (const BenchLoader& loader : loaders)
+	{
+		for (const string& file : files)
+		{
+			string extension = fs::path(file).extension().string();
+			transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+			if (find(loader.extensions.begin(), loader.extensions.end(), extension) == loader.extensions.end())
+				continue;
+
+			if (loader.prepare && !loader.prepare(file))
+			{
+				cerr << "skip " << loader.name << " " << file << endl;
+				continue;
+			}
+
+			BenchResult result;
+			if (!runLoader(loader, file, repeats, result))
+			{
+				cerr << "fail " << loader.name << " " << file << endl;
+				continue;
+			}
+
+			double fileBytes = (double)fs::file_size(file, error);
+			double seconds = result.medianMs / 1000.0;
+
+			char line[512];
+			snprintf(line, sizeof(line), "%s,%s,%s,%.0f,%zu,%d,%.3f,%.3f,%.2f,%.0f,%zu,%zu,%zu,%zu",
+				runId, loader.name.c_str(), fs::relative(file, modelsDir, error).generic_string().c_str(), fileBytes,
+				result.triangles, result.repeats, result.minMs, result.medianMs,
+				seconds > 0.0 ? fileBytes / (1024.0 * 1024.0) / seconds : 0.0,
+				seconds > 0.0 ? result.triangles / seconds : 0.0,
+				result.allocations, result.allocatedBytes, result.peakHeapBytes, result.peakRssKb);
+			out << line << endl;
+		}
+	}
+
+	fs::remove_all(cacheDir, error);
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+// Teste da cadeia de LODs do MeshSimplifier (ctest), sem janela nem contexto OpenGL.
+//
+// Para cada malha de entrada chama buildLods e confere que todo nivel gerado tem
+// triangulos e tem menos triangulos que o anterior. Malhas que nao podem ser
+// simplificadas (vazia, um triangulo, um quad) nao devem gerar nenhum nivel; uma grade
+// aberta deve gerar pelo menos um.
+//
+// Uso: MeshSimplifierTest (retorna 0 se todos os casos passarem)
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MeshSimplifier.h"
+
+using namespace std;
+
+struct TestMesh
+{
+	string name;
+	vector<float> positions;
+	vector<unsigned int> indices;
+	bool expectLods;
+};
+
+// Grade aberta de n x n quads no plano z = 0
+static TestMesh makeGrid(int n)
+{
+	TestMesh mesh;
+	mesh.name = "grid " + to_string(n) + "x" + to_string(n);
+	mesh.expectLods = true;
+
+	for (int y = 0; y <= n; y++)
+	{
+		for (int x = 0; x <= n; x++)
+		{
+			mesh.positions.push_back((float)x);
+			mesh.positions.push_back((float)y);
+			mesh.positions.push_back(0.0f);
+		}
+	}
+
+	for (int y = 0; y < n; y++)
+	{
+		for (int x = 0; x < n; x++)
+		{
+			unsigned int a = y * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+			mesh.indices.insert(mesh.indices.end(), { a, b, d, a, d, c });
+		}
+	}
+
+	return mesh;
+}
+
+static bool checkLods(const TestMesh& mesh)
+{
+	vector<unsigned int> indices = mesh.indices;
+	MeshParts parts;
+	parts.submeshes.push_back({ 0, (uint32_t)indices.size(), 0, -1 });
+
+	buildLods(indices, parts, mesh.positions.data(), 3 * sizeof(float), nullptr, 0, mesh.positions.size() / 3);
+
+	bool ok = true;
+	size_t previousTriangles = mesh.indices.size() / 3;
+
+	printf("%-12s %zu triangles, %zu LODs:", mesh.name.c_str(), previousTriangles, parts.lods.size());
+
+	for (const MeshLod& lod : parts.lods)
+	{
+		// Os triangulos das submeshes do nivel, conferidos contra o nbTriangles gravado
+		size_t nbTriangles = 0;
+		for (uint32_t i = lod.firstSubmesh; i < lod.firstSubmesh + lod.nbSubmeshes; i++)
+			nbTriangles += parts.lodSubmeshes[i].nbIndices / 3;
+
+		printf(" %zu", nbTriangles);
+
+		if (nbTriangles == 0 || nbTriangles != lod.nbTriangles || nbTriangles >= previousTriangles)
+			ok = false;
+		previousTriangles = nbTriangles;
+	}
+
+	if (mesh.expectLods != !parts.lods.empty())
+		ok = false;
+
+	printf(" -> %s\n", ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main()
+{
+	vector<TestMesh> meshes;
+
+	meshes.push_back({ "empty", {}, {}, false });
+	meshes.push_back({ "triangle", { 0, 0, 0, 1, 0, 0, 0, 1, 0 }, { 0, 1, 2 }, false });
+	meshes.push_back({ "quad", { 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0 }, { 0, 1, 2, 0, 2, 3 }, false });
+	meshes.push_back(makeGrid(16));
+
+	int failures = 0;
+	for (const TestMesh& mesh : meshes)
+		failures += checkLods(mesh) ? 0 : 1;
+
+	return failures == 0 ? 0 : 1;
+}
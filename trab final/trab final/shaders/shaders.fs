@@ -1,44 +1,92 @@
 #version 450
 
-in vec3 finalColor;
+// Variantes: o ShaderManager poe os #define das features do material logo abaixo do #version
+//   FEATURE_TEXTURE     cor base de tex_buffer (sem ela, branco)
+//   FEATURE_SPECULAR    parcela especular (sem ela, materiais com Ks 0 nao pagam o pow)
+//   FEATURE_NORMAL_MAP  normal de normal_buffer; sem tangentes nos vertices, a base vem das derivadas
+//   FEATURE_ALPHA_TEST  descarta o fragmento se o alfa da textura for menor que 0.5
+
 in vec3 scaledNormal;
 in vec2 texCoord;
 in vec3 fragPos;
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
+// Estado do frame, compartilhado por todos os programas (FrameUniforms)
+layout(std140) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	vec4 cameraPos;
+	vec4 lightPos;
+	vec4 lightColor;
+};
 
 uniform float ka;
 uniform float kd;
 uniform float ks;
 uniform float q;
 
-uniform vec3 cameraPos;
-
+#ifdef FEATURE_TEXTURE
 uniform sampler2D tex_buffer;
+#endif
+#ifdef FEATURE_NORMAL_MAP
+uniform sampler2D normal_buffer;
+
+// Base tangente pelas derivadas da posicao e da coordenada de textura no pixel
+mat3 cotangentFrame(vec3 N, vec3 p, vec2 uv)
+{
+	vec3 dp1 = dFdx(p);
+	vec3 dp2 = dFdy(p);
+	vec2 duv1 = dFdx(uv);
+	vec2 duv2 = dFdy(uv);
+
+	vec3 dp2perp = cross(dp2, N);
+	vec3 dp1perp = cross(N, dp1);
+	vec3 T = dp2perp * duv1.x + dp1perp * duv2.x;
+	vec3 B = dp2perp * duv1.y + dp1perp * duv2.y;
+
+	float invmax = inversesqrt(max(dot(T, T), dot(B, B)));
+	return mat3(T * invmax, B * invmax, N);
+}
+#endif
 
 out vec4 color;
 
 void main()
 {
-	vec3 ambient = ka * lightColor;
+#ifdef FEATURE_TEXTURE
+	vec4 texColor = texture(tex_buffer, texCoord);
+#ifdef FEATURE_ALPHA_TEST
+	if (texColor.a < 0.5)
+		discard;
+#endif
+#else
+	vec4 texColor = vec4(1.0);
+#endif
+
+	vec3 ambient = ka * lightColor.rgb;
 
 	//Cálculo da parcela de iluminação difusa
 	vec3 N = normalize(scaledNormal);
-	vec3 L = normalize(lightPos - fragPos);
+#ifdef FEATURE_NORMAL_MAP
+	vec3 mapNormal = texture(normal_buffer, texCoord).xyz * 2.0 - 1.0;
+	N = normalize(cotangentFrame(N, fragPos, texCoord) * mapNormal);
+#endif
+	vec3 L = normalize(lightPos.xyz - fragPos);
 	float diff = max(dot(N,L),0.0);
-	vec3 diffuse = kd * diff * lightColor;
+	vec3 diffuse = kd * diff * lightColor.rgb;
 
+	vec3 result = (ambient + diffuse) * texColor.rgb;
+
+#ifdef FEATURE_SPECULAR
 	//Cálculo da parcela de iluminação especular
-	vec3 V = normalize(cameraPos - fragPos);
+	vec3 V = normalize(cameraPos.xyz - fragPos);
 	vec3 R = normalize(reflect(-L,N));
 	float spec = max(dot(R,V),0.0);
 	spec = pow(spec,q);
-	vec3 specular = ks * spec * lightColor;
-
-	vec3 texColor = texture(tex_buffer, texCoord).xyz;
+	vec3 specular = ks * spec * lightColor.rgb;
 
-	vec3 result = (ambient + diffuse) * texColor + specular;
+	result += specular;
+#endif
 
 	color = vec4(result,1.0);
 }
\ No newline at end of file
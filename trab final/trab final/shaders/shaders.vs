@@ -1,24 +1,37 @@
 #version 450
 
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 tex_coord;
 layout (location = 3) in vec3 normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Estado do frame, compartilhado por todos os programas (FrameUniforms)
+layout(std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
+// Estado do objeto no frame, escrito no RingBuffer junto com o FrameData (Scene)
+layout(std140) uniform ObjectData
+{
+    mat4 model;
+    // Posicoes podem vir quantizadas (snorm16 relativo a AABB da malha)
+    vec4 positionOffset; // xyz
+    vec4 positionScale;  // xyz
+};
 
-out vec3 finalColor;
 out vec2 texCoord;
 out vec3 fragPos;
 out vec3 scaledNormal;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0);
-    finalColor = color;
+    vec3 objectPosition = position * positionScale.xyz + positionOffset.xyz;
+    gl_Position = projection * view * model * vec4(objectPosition, 1.0);
     texCoord = vec2(tex_coord.x, 1 - tex_coord.y);
     scaledNormal = normal;
-    fragPos = vec3(model * vec4(position, 1.0));
+    fragPos = vec3(model * vec4(objectPosition, 1.0));
 }
\ No newline at end of file